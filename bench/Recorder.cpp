@@ -0,0 +1,83 @@
+﻿#include "Recorder.h"
+
+#include "Graphics/Engine.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+using namespace CR::Graphics;
+
+namespace {
+	uint64_t Now() {
+		return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch())
+		    .count();
+	}
+
+	float Percentile(const vector<float>& a_sorted, float a_percentile) {
+		if(a_sorted.empty()) { return 0.0f; }
+		auto index = std::min(a_sorted.size() - 1, (size_t)(a_percentile * a_sorted.size()));
+		return a_sorted[index];
+	}
+}    // namespace
+
+void Bench::Recorder::BeginUpdate() {
+	m_updateStart = Now();
+}
+
+void Bench::Recorder::Frame() {
+	uint64_t start = Now();
+	bool rendered  = Graphics::Frame();
+	uint64_t end   = Now();
+
+	if(m_framesRun++ < m_warmupFrames || !rendered) { return; }
+
+	m_frameMs.push_back((end - start) / 1'000'000.0f);
+	if(m_updateStart != 0) { m_totals.UpdateMs += (start - m_updateStart) / 1'000'000.0f; }
+	m_updateStart = 0;
+
+	const FrameStats& stats = GetFrameStats();
+	m_totals.ExecutePendingMs += stats.ExecutePendingMs;
+	m_totals.CheckLoadingTasksMs += stats.CheckLoadingTasksMs;
+	m_totals.SpriteFrameMs += stats.SpriteFrameMs;
+	m_totals.DrawMs += stats.DrawMs;
+	m_totals.GpuWaitMs += stats.GpuWaitMs;
+
+	// gpu times lag a couple of frames, only count each one once
+	const GpuFrameTimes& gpuTimes = GetGpuFrameTimes();
+	if(gpuTimes.TotalMs > 0.0f && gpuTimes.FrameNumber != m_lastGpuFrame) {
+		m_lastGpuFrame = gpuTimes.FrameNumber;
+		++m_gpuFrames;
+		m_totals.GpuTotalMs += gpuTimes.TotalMs;
+		m_totals.GpuUploadMs += gpuTimes.UploadMs;
+		m_totals.GpuDrawMs += gpuTimes.DrawMs;
+		m_totals.GpuResolveMs += gpuTimes.ResolveMs;
+	}
+}
+
+Bench::Result Bench::Recorder::Finish() const {
+	Result result = m_totals;
+	result.Frames = (uint32_t)m_frameMs.size();
+
+	vector<float> sorted = m_frameMs;
+	sort(begin(sorted), end(sorted));
+	result.P50Ms = Percentile(sorted, 0.5f);
+	result.P90Ms = Percentile(sorted, 0.9f);
+	result.P99Ms = Percentile(sorted, 0.99f);
+	result.MaxMs = sorted.empty() ? 0.0f : sorted.back();
+
+	float frames = (float)std::max(result.Frames, 1u);
+	result.ExecutePendingMs /= frames;
+	result.CheckLoadingTasksMs /= frames;
+	result.SpriteFrameMs /= frames;
+	result.DrawMs /= frames;
+	result.GpuWaitMs /= frames;
+	result.UpdateMs /= frames;
+
+	float gpuFrames = (float)std::max(m_gpuFrames, 1u);
+	result.GpuTotalMs /= gpuFrames;
+	result.GpuUploadMs /= gpuFrames;
+	result.GpuDrawMs /= gpuFrames;
+	result.GpuResolveMs /= gpuFrames;
+	return result;
+}
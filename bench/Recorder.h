@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CR::Graphics::Bench {
+	// Averages are per rendered frame, frames skipped by the engine aren't counted.
+	struct Result {
+		std::string Scenario;
+		uint32_t Frames{0};
+
+		// wall clock time of the Frame call
+		float P50Ms{0.0f};
+		float P90Ms{0.0f};
+		float P99Ms{0.0f};
+		float MaxMs{0.0f};
+
+		// cpu phases, from Graphics::GetFrameStats
+		float ExecutePendingMs{0.0f};
+		float CheckLoadingTasksMs{0.0f};
+		float SpriteFrameMs{0.0f};
+		float DrawMs{0.0f};
+		float GpuWaitMs{0.0f};
+		float UpdateMs{0.0f};    // scenario's own work between frames, creating and moving sprites
+
+		// gpu phases, from Graphics::GetGpuFrameTimes. 0 if the device doesn't support timestamps.
+		float GpuTotalMs{0.0f};
+		float GpuUploadMs{0.0f};
+		float GpuDrawMs{0.0f};
+		float GpuResolveMs{0.0f};
+	};
+
+	// Runs frames for a scenario, and collects their timings once past the warm up.
+	class Recorder {
+	  public:
+		explicit Recorder(uint32_t a_warmupFrames) : m_warmupFrames(a_warmupFrames) {}
+
+		// Wrap the scenario's per frame work in these, Update is timed separately from the Frame call.
+		void BeginUpdate();
+		void Frame();
+
+		// Result.Scenario is left for the caller to fill in.
+		[[nodiscard]] Result Finish() const;
+
+	  private:
+		uint32_t m_warmupFrames{0};
+		uint32_t m_framesRun{0};
+		uint64_t m_lastGpuFrame{0};
+		uint32_t m_gpuFrames{0};
+		uint64_t m_updateStart{0};
+		std::vector<float> m_frameMs;
+		Result m_totals;
+	};
+}    // namespace CR::Graphics::Bench
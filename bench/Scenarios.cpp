@@ -0,0 +1,209 @@
+﻿#include "Scenarios.h"
+
+#include "Graphics/Engine.h"
+#include "Graphics/SpriteBasic.h"
+#include "Graphics/TextureSet.h"
+#include "Platform/MemoryMappedFile.h"
+#include "Platform/PathUtils.h"
+#include "core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	constexpr uint32_t c_maxSprites = 4096;
+	constexpr glm::vec2 c_screenSize{1280.0f, 720.0f};
+	constexpr glm::vec2 c_tileSize{88.0f, 88.0f};
+	const vector<const char*> c_tiles{"leaf", "brick", "diamond", "gold", "ice", "m", "question", "wood"};
+
+	// Keeps the crtexd files mapped for as long as the set is alive.
+	struct Textures {
+		vector<Platform::MemoryMappedFile> Files;
+		TextureSet Set;
+	};
+
+	Textures LoadTextures(const vector<const char*>& a_names) {
+		Textures result;
+		vector<TextureCreateInfo> infos;
+		result.Files.reserve(a_names.size());
+		for(const char* name : a_names) {
+			result.Files.emplace_back(Platform::GetCurrentProcessPath() / fmt::format("{}.crtexd", name));
+			TextureCreateInfo& info = infos.emplace_back();
+			info.Name               = name;
+			info.TextureData        = Core::Span<const byte>{result.Files.back().data(), result.Files.back().size()};
+		}
+		result.Set = TextureSet({infos.data(), infos.size()});
+		return result;
+	}
+
+	// Not timed, scenarios are about steady state, not load times.
+	void WaitForLoad(const TextureSet& a_set) {
+		for(int loops = 0; loops < 10000 && !a_set.IsLoaded(); ++loops) { Graphics::Frame(); }
+		Core::Log::Require(a_set.IsLoaded(), "bench textures never finished loading");
+	}
+
+	vector<shared_ptr<SpriteTemplateBasic>> CreateTileTemplates() {
+		vector<shared_ptr<SpriteTemplateBasic>> templates;
+		for(const char* tile : c_tiles) {
+			SpriteTemplateBasicCreateInfo info;
+			info.Name        = fmt::format("{} template", tile);
+			info.TextureName = tile;
+			info.FrameSize   = glm::uvec2(c_tileSize);
+			info.FrameRate   = eFrameRate::None;
+			templates.push_back(CreateSpriteTemplateBasic(info));
+		}
+		return templates;
+	}
+
+	struct Motion {
+		glm::vec2 Position;
+		glm::vec2 Step;
+		float Rotation;
+		float RotationStep;
+	};
+
+	Motion RandomMotion(mt19937& a_random, const glm::vec2& a_size) {
+		uniform_real_distribution<float> unit(0.0f, 1.0f);
+		uniform_real_distribution<float> step(-2.0f, 2.0f);
+		uniform_real_distribution<float> rotationStep(glm::radians(-2.0f), glm::radians(2.0f));
+		Motion result;
+		result.Position.x   = unit(a_random) * (c_screenSize.x - a_size.x);
+		result.Position.y   = unit(a_random) * (c_screenSize.y - a_size.y);
+		result.Step         = {step(a_random), step(a_random)};
+		result.Rotation     = unit(a_random) * glm::radians(360.0f);
+		result.RotationStep = rotationStep(a_random);
+		return result;
+	}
+
+	void Move(Motion& a_motion, const glm::vec2& a_size) {
+		a_motion.Position += a_motion.Step;
+		if(a_motion.Position.x > c_screenSize.x - a_size.x) { a_motion.Step.x = -fabs(a_motion.Step.x); }
+		if(a_motion.Position.x < 0.0f) { a_motion.Step.x = fabs(a_motion.Step.x); }
+		if(a_motion.Position.y > c_screenSize.y - a_size.y) { a_motion.Step.y = -fabs(a_motion.Step.y); }
+		if(a_motion.Position.y < 0.0f) { a_motion.Step.y = fabs(a_motion.Step.y); }
+		a_motion.Rotation = fmod(a_motion.Rotation + a_motion.RotationStep, glm::radians(360.0f));
+	}
+
+	SpriteBasic CreateSprite(const shared_ptr<SpriteTemplateBasic>& a_template, const Motion& a_motion) {
+		SpriteBasicCreateInfo info;
+		info.Name     = "bench sprite";
+		info.Template = a_template;
+		SpriteBasic sprite(info);
+		sprite.SetPosition(a_motion.Position);
+		sprite.SetRotation(a_motion.Rotation);
+		return sprite;
+	}
+
+	// N tile sprites scattered over the screen, optionally moving every frame, and optionally replacing a share of
+	// them every frame.
+	Bench::Result RunTiles(const Bench::Options& a_options, bool a_move, uint32_t a_churnPerFrame) {
+		Core::Log::Require(a_options.Sprites > 0, "scenarios need at least 1 sprite");
+		mt19937 random(a_options.Seed);
+		Textures textures = LoadTextures(c_tiles);
+		WaitForLoad(textures.Set);
+		auto templates = CreateTileTemplates();
+
+		uint32_t count = std::min(a_options.Sprites, c_maxSprites);
+		uniform_int_distribution<size_t> pickTemplate(0, templates.size() - 1);
+		uniform_int_distribution<uint32_t> pickSprite(0, count - 1);
+		vector<Motion> motions;
+		vector<SpriteBasic> sprites;
+		for(uint32_t i = 0; i < count; ++i) {
+			motions.push_back(RandomMotion(random, c_tileSize));
+			sprites.push_back(CreateSprite(templates[pickTemplate(random)], motions.back()));
+		}
+
+		Bench::Recorder recorder(a_options.WarmupFrames);
+		for(uint32_t frame = 0; frame < a_options.WarmupFrames + a_options.Frames; ++frame) {
+			recorder.BeginUpdate();
+			for(uint32_t i = 0; i < a_churnPerFrame; ++i) {
+				uint32_t index = pickSprite(random);
+				// free the old one first, or a full sprite manager can't fit the new one.
+				sprites[index] = SpriteBasic{};
+				motions[index] = RandomMotion(random, c_tileSize);
+				sprites[index] = CreateSprite(templates[pickTemplate(random)], motions[index]);
+			}
+			if(a_move) {
+				for(uint32_t i = 0; i < count; ++i) {
+					Move(motions[i], c_tileSize);
+					sprites[i].SetPosition(motions[i].Position);
+					sprites[i].SetRotation(motions[i].Rotation);
+				}
+			}
+			recorder.Frame();
+		}
+		return recorder.Finish();
+	}
+
+	Bench::Result RunStatic(const Bench::Options& a_options) {
+		return RunTiles(a_options, false, 0);
+	}
+
+	Bench::Result RunMoving(const Bench::Options& a_options) {
+		return RunTiles(a_options, true, 0);
+	}
+
+	Bench::Result RunChurn(const Bench::Options& a_options) {
+		return RunTiles(a_options, true, std::max(std::min(a_options.Sprites, c_maxSprites) / 8, 1u));
+	}
+
+	Bench::Result RunAnimated(const Bench::Options& a_options) {
+		mt19937 random(a_options.Seed);
+		Textures textures = LoadTextures({"BonusHarrySelect"});
+		WaitForLoad(textures.Set);
+
+		constexpr glm::vec2 frameSize{186.0f, 291.0f};
+		SpriteTemplateBasicCreateInfo templateInfo;
+		templateInfo.Name        = "harry template";
+		templateInfo.TextureName = "BonusHarrySelect";
+		templateInfo.FrameSize   = glm::uvec2(frameSize);
+		templateInfo.FrameRate   = eFrameRate::FPS20;
+		auto spriteTemplate      = CreateSpriteTemplateBasic(templateInfo);
+
+		uint32_t count = std::min(a_options.Sprites, c_maxSprites);
+		vector<SpriteBasic> sprites;
+		for(uint32_t i = 0; i < count; ++i) {
+			sprites.push_back(CreateSprite(spriteTemplate, RandomMotion(random, frameSize)));
+		}
+
+		Bench::Recorder recorder(a_options.WarmupFrames);
+		for(uint32_t frame = 0; frame < a_options.WarmupFrames + a_options.Frames; ++frame) { recorder.Frame(); }
+		return recorder.Finish();
+	}
+
+	// No sprites, just loading and freeing the tile texture set over and over. Frames spent waiting on the load are
+	// the ones timed.
+	Bench::Result RunTextureCycles(const Bench::Options& a_options) {
+		Bench::Recorder recorder(a_options.WarmupFrames);
+		uint32_t frames = 0;
+		while(frames < a_options.WarmupFrames + a_options.Frames) {
+			recorder.BeginUpdate();
+			Textures textures = LoadTextures(c_tiles);
+			while(!textures.Set.IsLoaded() && frames < a_options.WarmupFrames + a_options.Frames) {
+				recorder.Frame();
+				++frames;
+			}
+			recorder.BeginUpdate();
+			textures = Textures{};
+			recorder.Frame();
+			++frames;
+		}
+		return recorder.Finish();
+	}
+}    // namespace
+
+const vector<Bench::Scenario>& Bench::GetScenarios() {
+	static const vector<Scenario> scenarios{
+	    {"static", "sprites that never change, draw commands are reused", &RunStatic},
+	    {"moving", "every sprite moves and rotates every frame", &RunMoving},
+	    {"animated", "every sprite plays a 20fps animation", &RunAnimated},
+	    {"churn", "sprites moving, and an eighth of them replaced every frame", &RunChurn},
+	    {"texture_cycles", "tile texture set loaded and freed over and over", &RunTextureCycles},
+	};
+	return scenarios;
+}
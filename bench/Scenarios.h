@@ -0,0 +1,24 @@
+﻿#pragma once
+
+#include "Recorder.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace CR::Graphics::Bench {
+	struct Options {
+		uint32_t Sprites{4096};    // at least 1, clamped to the engine max of 4096
+		uint32_t Frames{600};
+		uint32_t WarmupFrames{60};
+		// everything random in a scenario comes from this, so runs are repeatable.
+		uint32_t Seed{1234};
+	};
+
+	struct Scenario {
+		const char* Name;
+		const char* Description;
+		Result (*Run)(const Options& a_options);
+	};
+
+	[[nodiscard]] const std::vector<Scenario>& GetScenarios();
+}    // namespace CR::Graphics::Bench
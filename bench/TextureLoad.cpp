@@ -0,0 +1,158 @@
+﻿#include "TextureLoad.h"
+
+#include "Graphics/Engine.h"
+#include "Platform/MemoryMappedFile.h"
+#include "Platform/PathUtils.h"
+
+#include "DataCompression/LosslessCompression.h"
+#include "core/BinaryStream.h"
+#include "core/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	const vector<const char*> c_testData{"CompletionScreen", "BonusHarrySelect", "leaf", "brick", "wood",
+	                                     "ice", "diamond", "gold", "m", "question"};
+
+	// Must match whats in TextureProcessor.
+#pragma pack(1)
+	struct Header {
+		static constexpr uint32_t c_FourCC{'CRTX'};
+		static constexpr uint32_t c_Version{1};
+		uint32_t FourCC{c_FourCC};
+		uint16_t Version{c_Version};
+		uint16_t Width{0};
+		uint16_t Height{0};
+		uint16_t Frames{0};
+	};
+#pragma pack()
+
+	float MsSince(chrono::steady_clock::time_point a_start) {
+		return chrono::duration<float, milli>(chrono::steady_clock::now() - a_start).count();
+	}
+
+	void WaitForLoad(const TextureSet& a_set) {
+		for(int loops = 0; loops < 100000 && !a_set.IsLoaded(); ++loops) { Graphics::Frame(); }
+		Core::Log::Require(a_set.IsLoaded(), "bench textures never finished loading");
+	}
+
+	Bench::TextureLoadResult Measure(const char* a_set, const vector<TextureCreateInfo>& a_textures) {
+		vector<TextureCreateInfo> infos = a_textures;
+		{
+			TextureSet warmup({infos.data(), infos.size()});
+			WaitForLoad(warmup);
+		}
+
+		Bench::TextureLoadResult result;
+		result.Set = a_set;
+		for(const auto& info : infos) { result.Bytes += info.TextureData.size(); }
+
+		ResetTextureLoadStats();
+		auto start = chrono::steady_clock::now();
+		TextureSet textures({infos.data(), infos.size()});
+		// callbacks only come from inside Frame, so none can be missed by setting it after creating the set.
+		textures.SetLoadedCallback([&](const string& a_name) {
+			auto info = find_if(begin(infos), end(infos),
+			                    [&](const TextureCreateInfo& a_info) { return a_info.Name == a_name; });
+			result.Textures.push_back({a_name, info->TextureData.size(), MsSince(start)});
+		});
+		WaitForLoad(textures);
+		result.TotalMs = MsSince(start);
+		result.Stats   = GetTextureLoadStats();
+		return result;
+	}
+
+	Bench::TextureLoadResult RunTestData(const Bench::Options&) {
+		vector<Platform::MemoryMappedFile> files;
+		vector<TextureCreateInfo> infos;
+		files.reserve(c_testData.size());
+		for(const char* name : c_testData) {
+			files.emplace_back(Platform::GetCurrentProcessPath() / fmt::format("{}.crtexd", name));
+			TextureCreateInfo& info = infos.emplace_back();
+			info.Name               = name;
+			info.TextureData        = Core::Span<const byte>{files.back().data(), files.back().size()};
+		}
+		return Measure("test_data", infos);
+	}
+
+	// A crtex file of made up bc7 blocks. Blocks are picked from a small palette, often repeating the last one, so
+	// zstd has something to find, as it does in real textures. Fully random blocks wouldn't compress at all.
+	vector<byte> CreateCrtex(mt19937& a_random, uint16_t a_width, uint16_t a_height, uint16_t a_frames) {
+		constexpr size_t c_blockSize   = 16;
+		constexpr size_t c_paletteSize = 256;
+		vector<byte> palette(c_paletteSize * c_blockSize);
+		uniform_int_distribution<uint32_t> randomByte(0, 255);
+		for(auto& value : palette) { value = (byte)randomByte(a_random); }
+		uniform_int_distribution<size_t> pickBlock(0, c_paletteSize - 1);
+		bernoulli_distribution repeat(0.5);
+
+		Header header;
+		header.Width  = a_width;
+		header.Height = a_height;
+		header.Frames = a_frames;
+		vector<byte> result;
+		Core::Write(result, header);
+
+		size_t blocks = (a_width / 4) * (a_height / 4);
+		vector<byte> frame(blocks * c_blockSize);
+		for(uint16_t i = 0; i < a_frames; ++i) {
+			size_t block = pickBlock(a_random);
+			for(size_t offset = 0; offset < frame.size(); offset += c_blockSize) {
+				if(!repeat(a_random)) { block = pickBlock(a_random); }
+				memcpy(frame.data() + offset, palette.data() + block * c_blockSize, c_blockSize);
+			}
+			auto compressed = DataCompression::Compress(Core::Span<const byte>(frame.data(), frame.size()));
+			Core::Write(result, vector<byte>(compressed.data(), compressed.data() + compressed.size()));
+		}
+		return result;
+	}
+
+	Bench::TextureLoadResult RunSynthetic(const Bench::Options& a_options, const char* a_set, uint32_t a_count,
+	                                      uint16_t a_size, uint16_t a_frames) {
+		mt19937 random(a_options.Seed);
+		vector<vector<byte>> files;
+		vector<TextureCreateInfo> infos;
+		files.reserve(a_count);
+		for(uint32_t i = 0; i < a_count; ++i) {
+			files.push_back(CreateCrtex(random, a_size, a_size, a_frames));
+			TextureCreateInfo& info = infos.emplace_back();
+			info.Name               = fmt::format("{}_{}", a_set, i);
+			info.TextureData        = Core::Span<const byte>{files.back().data(), files.back().size()};
+		}
+		return Measure(a_set, infos);
+	}
+
+	Bench::TextureLoadResult RunSynthetic2k(const Bench::Options& a_options) {
+		return RunSynthetic(a_options, "synthetic_2k", 32, 2048, 1);
+	}
+
+	Bench::TextureLoadResult RunSynthetic4k(const Bench::Options& a_options) {
+		return RunSynthetic(a_options, "synthetic_4k", 4, 4096, 1);
+	}
+
+	Bench::TextureLoadResult RunSyntheticFrames(const Bench::Options& a_options) {
+		return RunSynthetic(a_options, "synthetic_frames", 8, 1024, 16);
+	}
+}    // namespace
+
+const vector<Bench::TextureLoadSet>& Bench::GetTextureLoadSets() {
+	static const vector<TextureLoadSet> sets{
+	    {"test_data", "every texture in tests/data", &RunTestData},
+	    {"synthetic_2k", "32 2048x2048 textures", &RunSynthetic2k},
+	    {"synthetic_4k", "4 4096x4096 textures, the largest the staging buffer fits", &RunSynthetic4k},
+	    {"synthetic_frames", "8 1024x1024 textures with 16 frames each, lots of small copies", &RunSyntheticFrames},
+	};
+	return sets;
+}
+
+float Bench::MBPerSecond(const TextureLoadStats::Stage& a_stage) {
+	if(a_stage.Ms <= 0.0f) { return 0.0f; }
+	return (a_stage.Bytes / (1024.0f * 1024.0f)) / (a_stage.Ms / 1000.0f);
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include "Scenarios.h"
+
+#include "Graphics/TextureSet.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Texture loading throughput, run with --texture-load instead of the sprite scenarios. Each set is loaded once
+// untimed, to warm up the file cache and the loading thread, then once more timed.
+namespace CR::Graphics::Bench {
+	struct TextureReady {
+		std::string Name;
+		uint64_t Bytes{0};      // crtex file size
+		float ReadyMs{0.0f};    // from starting to create the set, until the texture could be drawn
+	};
+
+	struct TextureLoadResult {
+		std::string Set;
+		uint64_t Bytes{0};
+		float TotalMs{0.0f};    // from starting to create the set, until all of it could be drawn
+		TextureLoadStats Stats;
+		std::vector<TextureReady> Textures;    // in the order they became ready
+	};
+
+	struct TextureLoadSet {
+		const char* Name;
+		const char* Description;
+		TextureLoadResult (*Run)(const Options& a_options);
+	};
+
+	[[nodiscard]] const std::vector<TextureLoadSet>& GetTextureLoadSets();
+	[[nodiscard]] float MBPerSecond(const TextureLoadStats::Stage& a_stage);
+}    // namespace CR::Graphics::Bench
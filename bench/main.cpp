@@ -0,0 +1,190 @@
+﻿#include "Scenarios.h"
+#include "TextureLoad.h"
+
+#include "Graphics/Engine.h"
+#include "Platform/PathUtils.h"
+
+#include <3rdParty/glfw.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	void PrintUsage() {
+		fmt::print("graphics_bench [options]\n"
+		           "  --scenario <name>  only run this scenario or texture set, can be repeated\n"
+		           "  --sprites <count>  sprites per scenario, 1 to 4096\n"
+		           "  --frames <count>   frames timed per scenario\n"
+		           "  --warmup <count>   frames run before timing starts\n"
+		           "  --seed <seed>      seed for everything random\n"
+		           "  --csv <file>       also append results to this csv file, columns depend on the mode\n"
+		           "  --null             no gpu, only times the cpu side of the engine\n"
+		           "  --texture-load     measure texture loading instead of running the scenarios\n"
+		           "scenarios:\n");
+		for(const auto& scenario : Bench::GetScenarios()) {
+			fmt::print("  {:<16} {}\n", scenario.Name, scenario.Description);
+		}
+		fmt::print("texture sets:\n");
+		for(const auto& set : Bench::GetTextureLoadSets()) { fmt::print("  {:<16} {}\n", set.Name, set.Description); }
+	}
+
+	bool Selected(const vector<string>& a_only, const char* a_name) {
+		return a_only.empty() || find(begin(a_only), end(a_only), a_name) != end(a_only);
+	}
+
+	void PrintResult(const Bench::Result& a_result) {
+		fmt::print("{:<16} {:>6} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f} | {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f} "
+		           "{:>8.3f} | {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f}\n",
+		           a_result.Scenario, a_result.Frames, a_result.P50Ms, a_result.P90Ms, a_result.P99Ms, a_result.MaxMs,
+		           a_result.UpdateMs, a_result.ExecutePendingMs, a_result.CheckLoadingTasksMs, a_result.SpriteFrameMs,
+		           a_result.DrawMs, a_result.GpuWaitMs, a_result.GpuTotalMs, a_result.GpuUploadMs, a_result.GpuDrawMs,
+		           a_result.GpuResolveMs);
+	}
+
+	void AppendCsv(const filesystem::path& a_path, const Bench::Result& a_result) {
+		bool newFile = !filesystem::exists(a_path);
+		ofstream file(a_path, ios::app);
+		if(newFile) {
+			file << "scenario,frames,p50_ms,p90_ms,p99_ms,max_ms,update_ms,execute_pending_ms,check_loading_tasks_ms,"
+			        "sprite_frame_ms,draw_ms,gpu_wait_ms,gpu_total_ms,gpu_upload_ms,gpu_draw_ms,gpu_resolve_ms\n";
+		}
+		file << fmt::format("{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n", a_result.Scenario, a_result.Frames,
+		                    a_result.P50Ms, a_result.P90Ms, a_result.P99Ms, a_result.MaxMs, a_result.UpdateMs,
+		                    a_result.ExecutePendingMs, a_result.CheckLoadingTasksMs, a_result.SpriteFrameMs,
+		                    a_result.DrawMs, a_result.GpuWaitMs, a_result.GpuTotalMs, a_result.GpuUploadMs,
+		                    a_result.GpuDrawMs, a_result.GpuResolveMs);
+	}
+
+	void PrintTextureLoad(const Bench::TextureLoadResult& a_result) {
+		const TextureLoadStats& stats = a_result.Stats;
+		fmt::print("{:<16} {:>8} {:>8.1f} {:>8.1f} | {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n", a_result.Set,
+		           stats.TexturesLoaded, a_result.Bytes / (1024.0f * 1024.0f), a_result.TotalMs,
+		           Bench::MBPerSecond(stats.Read), Bench::MBPerSecond(stats.Decode), Bench::MBPerSecond(stats.Staging),
+		           Bench::MBPerSecond(stats.GpuCopy));
+		for(const auto& texture : a_result.Textures) {
+			fmt::print("    {:<24} {:>10.1f}KB ready at {:>8.2f}ms\n", texture.Name, texture.Bytes / 1024.0f,
+			           texture.ReadyMs);
+		}
+	}
+
+	void AppendTextureLoadCsv(const filesystem::path& a_path, const Bench::TextureLoadResult& a_result) {
+		bool newFile = !filesystem::exists(a_path);
+		ofstream file(a_path, ios::app);
+		if(newFile) {
+			file << "set,textures,bytes,total_ms,read_mbps,decode_mbps,staging_mbps,gpu_copy_mbps,p50_ready_ms,"
+			        "max_ready_ms\n";
+		}
+		vector<float> readyMs;
+		for(const auto& texture : a_result.Textures) { readyMs.push_back(texture.ReadyMs); }
+		sort(begin(readyMs), end(readyMs));
+		float p50 = readyMs.empty() ? 0.0f : readyMs[readyMs.size() / 2];
+		float max = readyMs.empty() ? 0.0f : readyMs.back();
+		const TextureLoadStats& stats = a_result.Stats;
+		file << fmt::format("{},{},{},{},{},{},{},{},{},{}\n", a_result.Set, stats.TexturesLoaded, a_result.Bytes,
+		                    a_result.TotalMs, Bench::MBPerSecond(stats.Read), Bench::MBPerSecond(stats.Decode),
+		                    Bench::MBPerSecond(stats.Staging), Bench::MBPerSecond(stats.GpuCopy), p50, max);
+	}
+
+	void RunScenarios(const Bench::Options& a_options, const vector<string>& a_only, const filesystem::path& a_csv) {
+		fmt::print("{:<16} {:>6} {:>8} {:>8} {:>8} {:>8} | {:>8} {:>8} {:>8} {:>8} {:>8} {:>8} | {:>8} {:>8} {:>8} "
+		           "{:>8}\n",
+		           "scenario", "frames", "p50", "p90", "p99", "max", "update", "pending", "loading", "sprites", "draw",
+		           "gpuwait", "gpu", "upload", "draw", "resolve");
+		for(const auto& scenario : Bench::GetScenarios()) {
+			if(!Selected(a_only, scenario.Name)) { continue; }
+			Bench::Result result = scenario.Run(a_options);
+			result.Scenario      = scenario.Name;
+			PrintResult(result);
+			if(!a_csv.empty()) { AppendCsv(a_csv, result); }
+		}
+	}
+
+	// Throughput is in MB/s for each stage of the loading thread's pipeline.
+	void RunTextureLoad(const Bench::Options& a_options, const vector<string>& a_only, const filesystem::path& a_csv) {
+		fmt::print("{:<16} {:>8} {:>8} {:>8} | {:>10} {:>10} {:>10} {:>10}\n", "set", "textures", "MB", "total ms",
+		           "read", "decode", "staging", "gpu copy");
+		for(const auto& set : Bench::GetTextureLoadSets()) {
+			if(!Selected(a_only, set.Name)) { continue; }
+			Bench::TextureLoadResult result = set.Run(a_options);
+			PrintTextureLoad(result);
+			if(!a_csv.empty()) { AppendTextureLoadCsv(a_csv, result); }
+		}
+	}
+}    // namespace
+
+// Runs each scenario against a real device unless --null is given. For a headless run on a machine without a gpu,
+// point VK_ICD_FILENAMES at a software driver(lavapipe, swiftshader), the window is never shown.
+int main(int argc, char** argv) {
+	Bench::Options options;
+	bool nullBackend = false;
+	bool textureLoad = false;
+	vector<string> onlyScenarios;
+	filesystem::path csvPath;
+	for(int i = 1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+		if(strcmp(argv[i], "--null") == 0) {
+			nullBackend = true;
+		} else if(strcmp(argv[i], "--texture-load") == 0) {
+			textureLoad = true;
+		} else if(strcmp(argv[i], "--scenario") == 0 && hasValue) {
+			onlyScenarios.emplace_back(argv[++i]);
+		} else if(strcmp(argv[i], "--sprites") == 0 && hasValue) {
+			options.Sprites = (uint32_t)atoi(argv[++i]);
+			if(options.Sprites == 0) {
+				fmt::print("--sprites must be at least 1\n");
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--frames") == 0 && hasValue) {
+			options.Frames = (uint32_t)atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--warmup") == 0 && hasValue) {
+			options.WarmupFrames = (uint32_t)atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+			options.Seed = (uint32_t)atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--csv") == 0 && hasValue) {
+			csvPath = argv[++i];
+		} else {
+			PrintUsage();
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	glfwInit();
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(1280, 720, "graphics_bench", nullptr, nullptr);
+
+	EngineSettings settings;
+	settings.ApplicationName    = "graphics_bench";
+	settings.ApplicationVersion = 1;
+	// validation would swamp everything being measured
+	settings.EnableDebug        = false;
+	settings.ExtensionsToEnable = glfwGetRequiredInstanceExtensions(&settings.ExtensionsToEnableCount);
+	settings.Hwnd               = glfwGetWin32Window(window);
+	settings.HInstance          = GetModuleHandle(nullptr);
+	settings.ClearColor         = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	// no vsync, so frame times are the engine's and not the display's
+	settings.PresentationMode  = PresentMode::Immediate;
+	settings.PipelineCachePath = Platform::GetCurrentProcessPath() / "bench_pipeline.cache";
+	settings.NullBackend       = nullBackend;
+	CreateEngine(settings);
+
+	if(textureLoad) {
+		RunTextureLoad(options, onlyScenarios, csvPath);
+	} else {
+		RunScenarios(options, onlyScenarios, csvPath);
+	}
+
+	ShutdownEngine();
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
@@ -13,16 +13,21 @@ set(PUBLIC_HDRS
 )
 
 set(SRCS
+    ${root}/src/ApiRecorder.h
+    ${root}/src/ApiRecorder.cpp
     ${root}/src/AssetLoadingThread.h
     ${root}/src/AssetLoadingThread.cpp
     ${root}/src/Commands.h
     ${root}/src/CommandPool.h
     ${root}/src/Constants.h
+    ${root}/src/CompletionQueue.h
     ${root}/src/DescriptorPool.h
     ${root}/src/DescriptorPool.cpp
     ${root}/src/Event.h
     ${root}/src/Event.cpp
     ${root}/src/Formats.h
+    ${root}/src/MemoryAllocator.h
+    ${root}/src/MemoryAllocator.cpp
     ${root}/src/SpriteBasic.cpp
     ${root}/src/SpriteTemplateBasicImpl.h
     ${root}/src/SpriteTemplateBasic.cpp
@@ -32,14 +37,32 @@ set(SRCS
     ${root}/src/TextureSets.cpp
     ${root}/src/EngineInternal.h
     ${root}/src/Engine.cpp
+    ${root}/src/GpuProfiler.h
+    ${root}/src/GpuProfiler.cpp
+    ${root}/src/FrameCounters.h
+    ${root}/src/FrameCounters.cpp
+    ${root}/src/HostAllocator.h
+    ${root}/src/HostAllocator.cpp
+    ${root}/src/NullDevice.h
+    ${root}/src/NullDevice.cpp
+    ${root}/src/Trace.h
+    ${root}/src/Trace.cpp
     ${root}/src/UniformBufferDynamic.h
     ${root}/src/UniformBufferDynamic.cpp
+    ${root}/src/UniformBufferRing.h
+    ${root}/src/UniformBufferRing.cpp
     ${root}/src/VertexBuffer.h
     ${root}/src/VertexBuffer.cpp
     ${root}/src/CommandPool.cpp
     ${root}/src/Commands.cpp
     ${root}/src/Pipeline.h
     ${root}/src/Pipeline.cpp
+    ${root}/src/PipelineCache.h
+    ${root}/src/PipelineCache.cpp
+    ${root}/src/PipelineCompileThread.h
+    ${root}/src/PipelineCompileThread.cpp
+    ${root}/src/RecordingThreads.h
+    ${root}/src/RecordingThreads.cpp
     ${root}/src/VulkanWindows.h
     ${root}/src/shaders/Basic.h
     ${root}/src/shaders/Basic.cpp
@@ -72,6 +95,8 @@ target_include_directories(graphics PUBLIC
 	"${root}/inc"
 )
 target_compile_definitions(graphics PRIVATE VK_USE_PLATFORM_WIN32_KHR)
+# all vulkan calls go through a dispatcher the engine fills in, so it can be pointed at the null backend.
+target_compile_definitions(graphics PUBLIC VULKAN_HPP_DISPATCH_LOADER_DYNAMIC=1)
 target_include_directories(graphics PRIVATE
 	"${root}/src"
 	$ENV{VULKAN_SDK}/include
@@ -93,6 +118,7 @@ target_link_libraries(graphics PUBLIC
 set(SRCS
   ${root}/tests/TestFixture.h
   ${root}/tests/main.cpp
+  ${root}/tests/ApiRecorder.cpp
   ${root}/tests/Engine.cpp
   ${root}/tests/UniformBufferDynamic.cpp
   ${root}/tests/TextureSet.cpp
@@ -185,4 +211,82 @@ add_custom_command(TARGET graphics_tests POST_BUILD
     COMMAND $<TARGET_FILE:TextureProcessor> -i ${root}/tests/data/question -o $<TARGET_FILE_DIR:graphics_tests>/question -p
 )
 
-set_property(TARGET graphics_tests APPEND PROPERTY FOLDER tests)
\ No newline at end of file
+set_property(TARGET graphics_tests APPEND PROPERTY FOLDER tests)
+###############################################
+#benchmarks
+###############################################
+set(BENCH_SRCS
+  ${root}/bench/main.cpp
+  ${root}/bench/Recorder.h
+  ${root}/bench/Recorder.cpp
+  ${root}/bench/Scenarios.h
+  ${root}/bench/Scenarios.cpp
+  ${root}/bench/TextureLoad.h
+  ${root}/bench/TextureLoad.cpp
+)
+
+add_executable(graphics_bench
+					${BENCH_SRCS}
+)
+
+settingsCR(graphics_bench)	
+usePCH(graphics_bench core)
+
+target_link_libraries(graphics_bench 
+	fmt
+	zstd
+	core
+	datacompression
+	platform
+	graphics
+	Vulkan::Vulkan 
+	glfw
+)
+
+add_dependencies(graphics_bench TextureProcessor)
+
+add_custom_command(TARGET graphics_bench POST_BUILD        
+COMMAND ${CMAKE_COMMAND} -E copy_if_different  
+	"${glfw_dll}"
+	$<TARGET_FILE_DIR:graphics_bench>)
+
+foreach(texture CompletionScreen BonusHarrySelect leaf brick wood ice diamond gold m question)
+	add_custom_command(TARGET graphics_bench POST_BUILD
+		COMMAND $<TARGET_FILE:TextureProcessor> -i ${root}/tests/data/${texture} -o $<TARGET_FILE_DIR:graphics_bench>/${texture} -p
+	)
+endforeach()
+
+set_property(TARGET graphics_bench APPEND PROPERTY FOLDER bench)
+
+###############################################
+#replay
+###############################################
+add_executable(graphics_replay
+					${root}/replay/main.cpp
+)
+
+settingsCR(graphics_replay)	
+usePCH(graphics_replay core)
+
+# for the recording format in ApiRecorder.h
+target_include_directories(graphics_replay PRIVATE
+	"${root}/src"
+)	
+
+target_link_libraries(graphics_replay 
+	fmt
+	zstd
+	core
+	datacompression
+	platform
+	graphics
+	Vulkan::Vulkan 
+	glfw
+)
+
+add_custom_command(TARGET graphics_replay POST_BUILD        
+COMMAND ${CMAKE_COMMAND} -E copy_if_different  
+	"${glfw_dll}"
+	$<TARGET_FILE_DIR:graphics_replay>)
+
+set_property(TARGET graphics_replay APPEND PROPERTY FOLDER replay)
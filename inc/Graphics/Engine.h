@@ -2,11 +2,20 @@
 
 #include <3rdParty/glm.h>
 
+#include <filesystem>
 #include <functional>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace CR::Graphics {
+	enum class PresentMode {
+		Fifo,           // vsync, always supported. Lowest power.
+		FifoRelaxed,    // vsync, but tears instead of waiting a whole refresh when a frame is late.
+		Mailbox,        // no tearing, newest frame wins at vsync. Low latency, use at least 3 swap chain images.
+		Immediate,      // no vsync, tears. Lowest latency.
+	};
+
 	struct EngineSettings {
 		std::string ApplicationName;
 		uint32_t ApplicationVersion{0};
@@ -19,7 +28,7 @@ namespace CR::Graphics {
 		uint32_t ExtensionsToEnableCount{0};
 
 		// Little bit hacky, I don't want to include windows.h. so just pass hinstance and hwnd ad void*'s
-		// Headless mode isn't currently supported, you must provide a window.
+		// Headless mode isn't currently supported, you must provide a window. Unless using NullBackend.
 #ifdef WIN32
 		void* HInstance{nullptr};
 		void* Hwnd{nullptr};
@@ -29,11 +38,111 @@ namespace CR::Graphics {
 		// Note, this isn't setting the refresh rate, its the application letting the engine
 		// know what the refresh rate currently is.
 		uint32_t RefreshRate{60};
+
+		// Falls back to Fifo if the requested mode isn't supported.
+		PresentMode PresentationMode{PresentMode::Fifo};
+		// Clamped to what the surface supports.
+		uint32_t SwapChainImages{2};
+		// Max frames per second, Frame sleeps to stay under it. 0 for no limit. Mostly useful with Mailbox or
+		// Immediate, to save battery.
+		uint32_t FrameLimit{0};
+
+		// Compiled pipelines are loaded from, and saved to at shutdown, this file. Speeds up startup a lot on some
+		// drivers. Leave empty to not use a cache file. Should be somewhere writable, i.e. user app data.
+		std::filesystem::path PipelineCachePath;
+
+		// Quality settings, lower these for a cheaper fill rate on low end hardware.
+		// Must be 1, 2, 4, or 8. Falls back to the highest count the device supports if this one isn't.
+		uint32_t MsaaSamples{4};
+		// Run the fragment shader for every sample, instead of once per pixel. Very expensive.
+		bool SampleShading{true};
+
+		// Keep draw command buffers around and only re-record them when the draw changes, not just the data. Saves cpu
+		// time on mostly static screens, menus and the like.
+		bool ReuseDrawCommands{true};
+		// Frame does no gpu work and presents nothing when nothing on screen changed, just waits out a refresh. For
+		// mostly static screens, saves a lot of power.
+		bool SkipUnchangedFrames{false};
+
+		// Serve the driver's small cpu side allocations out of pools instead of the heap. Try it if HostAllocations in
+		// the frame stats is high.
+		bool PoolHostAllocations{false};
+
+		// No gpu, or vulkan driver, needed. Resources aren't really created and nothing is ever drawn, but all the cpu
+		// side work still happens. For tests and benchmarks on machines without a gpu. The surface is always 1280x720.
+		bool NullBackend{false};
+
+		// Record every call to the public api into this file, for replaying the session later with graphics_replay.
+		// Leave empty to not record. Costs a little cpu per call, and the file grows by a few bytes per sprite change.
+		std::filesystem::path RecordPath;
+	};
+
+	// Gpu time spent on each part of a frame. Lags a couple of frames behind, FrameNumber is the frame they are from.
+	// All 0 if the gpu doesn't support timestamps.
+	struct GpuFrameTimes {
+		struct Scope {
+			const char* Name{nullptr};
+			float Ms{0.0f};
+		};
+
+		uint64_t FrameNumber{0};
+		float TotalMs{0.0f};
+		float UploadMs{0.0f};     // copies and layout transitions before the render pass
+		float DrawMs{0.0f};       // the render pass
+		float ResolveMs{0.0f};    // end of the render pass, msaa resolve and storing the swap chain image
+		// Any other timed scopes in the frame, in the order they were started.
+		std::vector<Scope> Scopes;
+	};
+
+	// Cpu side numbers for one rendered frame. Times are wall clock, on the thread calling Frame.
+	struct FrameStats {
+		uint64_t FrameNumber{0};
+		float ExecutePendingMs{0.0f};
+		float CheckLoadingTasksMs{0.0f};
+		float SpriteFrameMs{0.0f};
+		float DrawMs{0.0f};       // recording draws, including waiting on the recording threads
+		float GpuWaitMs{0.0f};    // blocked acquiring a swap chain image, or on the gpu catching up
+		uint32_t SpritesDrawn{0};
+		uint64_t BytesUploaded{0};    // buffer to buffer copies, i.e. vertex data without ReBAR
+		uint32_t DescriptorWrites{0};
+		uint32_t CommandBuffersAllocated{0};    // from the driver, reused ones don't count
+		uint32_t PendingAssetLoads{0};
+		uint32_t HostAllocations{0};    // driver cpu side allocations, should be 0 most frames
+	};
+	inline constexpr uint32_t c_frameStatsHistory = 120;
+
+	// Lifetime of a driver cpu side allocation, same order as VkSystemAllocationScope.
+	enum class HostAllocationScope : uint32_t { Command, Object, Cache, Device, Instance, Count };
+
+	// Current driver cpu side memory use, indexed by HostAllocationScope.
+	struct HostMemoryStats {
+		struct Scope {
+			uint64_t Bytes{0};
+			uint32_t Allocations{0};
+			uint64_t TotalAllocations{0};    // since startup
+			uint64_t InternalBytes{0};       // allocated by the driver itself, we are only told about it
+		};
+
+		Scope Scopes[(uint32_t)HostAllocationScope::Count];
+		uint64_t PooledBytes{0};    // reserved by PoolHostAllocations, whether in use or not
 	};
 
 	void CreateEngine(const EngineSettings& a_settings);
-	// This will block until GPU is idle(to minimize latency), so should not be including in a simple wall clock
-	// profiler
-	void Frame();
+	// Blocks if the gpu falls more than a couple of frames behind, and sleeps to honor FrameLimit, so should not be
+	// included in a simple wall clock profiler. Returns false if no frame was rendered, because of SkipUnchangedFrames
+	// or a minimized window.
+	bool Frame();
+	// Call when the window changes size, the swap chain is rebuilt at the start of the next frame. Frames are skipped
+	// while the window is minimized.
+	void WindowResized();
 	void ShutdownEngine();
+
+	[[nodiscard]] const GpuFrameTimes& GetGpuFrameTimes();
+	// a_framesAgo of 0 is the last rendered frame, up to c_frameStatsHistory-1. Clamped to the frames rendered so far,
+	// all 0 before the first one.
+	[[nodiscard]] const FrameStats& GetFrameStats(uint32_t a_framesAgo = 0);
+	[[nodiscard]] HostMemoryStats GetHostMemoryStats();
+	// Dumps the most recent engine trace events as chrome trace json. Tracing is compiled out of final builds, always
+	// returns false there.
+	bool WriteTrace(const std::filesystem::path& a_path);
 }    // namespace CR::Graphics
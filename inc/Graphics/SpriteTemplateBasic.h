@@ -17,12 +17,20 @@ namespace CR::Graphics {
 	};
 
 	enum class eFrameRate { None, FPS10, FPS12, FPS15, FPS20, FPS30, FPS60 };
+	// How a sprite is combined with whatever was drawn under it.
+	enum class eBlendMode { None, Alpha, PremultipliedAlpha, Additive };
 
 	struct SpriteTemplateBasicCreateInfo {
 		std::string Name;
 		std::string TextureName;
 		glm::uvec2 FrameSize;
 		eFrameRate FrameRate;
+		// Every combination of BlendMode and SampleShading in use needs its own pipeline, compiled in the background
+		// the first time a template asks for it. Sprites from the template aren't drawn until then.
+		eBlendMode BlendMode{eBlendMode::None};
+		// Per sample shading, smoother edges inside the sprite but much more expensive. Only if
+		// EngineSettings::SampleShading is on as well.
+		bool SampleShading{true};
 	};
 	std::shared_ptr<SpriteTemplateBasic> CreateSpriteTemplateBasic(const SpriteTemplateBasicCreateInfo& a_info);
 }    // namespace CR::Graphics
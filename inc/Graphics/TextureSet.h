@@ -2,6 +2,8 @@
 
 #include "core/Span.h"
 
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -21,9 +23,34 @@ namespace CR::Graphics {
 		TextureSet& operator=(const TextureSet&) = delete;
 		TextureSet& operator                     =(TextureSet&& a_other) noexcept;
 
+		// True once every texture in the set has finished loading and can be drawn. Always false for an empty set.
+		[[nodiscard]] bool IsLoaded() const;
+		// Called from inside Frame(), once for each texture in the set as it finishes loading. Intended for loading
+		// screens. Textures that finished before the callback was set will not be reported.
+		void SetLoadedCallback(std::function<void(const std::string&)> a_callback);
+
 	  private:
+		void Free();
+
 		inline static constexpr uint16_t c_unused{0xffff};
 
 		uint16_t m_id{c_unused};
 	};
+
+	// Where texture loading time goes, totals since startup or the last ResetTextureLoadStats. Times are wall clock on
+	// the thread doing the work, stages never overlap so they can be compared directly.
+	struct TextureLoadStats {
+		struct Stage {
+			uint64_t Bytes{0};
+			float Ms{0.0f};
+		};
+
+		Stage Read;       // copying the crtex data out of TextureCreateInfo, includes paging in a memory mapped file
+		Stage Decode;     // zstd, Bytes is the decompressed size
+		Stage Staging;    // memcpy into the staging buffer
+		Stage GpuCopy;    // staging buffer to image copy, from submit until the transfer queue is idle
+		uint32_t TexturesLoaded{0};
+	};
+	[[nodiscard]] TextureLoadStats GetTextureLoadStats();
+	void ResetTextureLoadStats();
 }    // namespace CR::Graphics
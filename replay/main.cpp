@@ -0,0 +1,238 @@
+﻿#include "ApiRecorder.h"
+
+#include "Graphics/Engine.h"
+#include "Graphics/SpriteBasic.h"
+#include "Graphics/SpriteTemplateBasic.h"
+#include "Graphics/TextureSet.h"
+#include "Platform/MemoryMappedFile.h"
+#include "Platform/PathUtils.h"
+
+#include "core/Log.h"
+
+#include <3rdParty/glfw.h>
+#include <3rdParty/robinmap.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+using ApiCall = ApiRecorder::ApiCall;
+
+namespace {
+	struct Options {
+		bool NullBackend{false};
+		// sleep between frames to match the recorded frame times, instead of replaying as fast as possible.
+		bool Paced{false};
+	};
+
+	class Replay {
+	  public:
+		Replay(const Options& a_options) : m_options(a_options) {}
+
+		// Returns false if the recording was cut off part way through a record. Everything before that is still
+		// replayed, and the engine shut down.
+		bool Run(ApiRecorder::Reader& a_reader) {
+			bool complete = true;
+			try {
+				while(!a_reader.AtEnd()) {
+					switch(a_reader.ReadCall()) {
+						case ApiCall::CreateEngine:
+							CreateEngine(a_reader);
+							break;
+						case ApiCall::ShutdownEngine:
+							ShutdownEngine();
+							return true;
+						case ApiCall::Frame:
+							Frame(a_reader);
+							break;
+						case ApiCall::WindowResized:
+							Graphics::WindowResized();
+							break;
+						case ApiCall::TextureData:
+							TextureData(a_reader);
+							break;
+						case ApiCall::CreateTextureSet:
+							CreateTextureSet(a_reader);
+							break;
+						case ApiCall::DestroyTextureSet:
+							m_textureSets.erase(a_reader.Read<uint16_t>());
+							break;
+						case ApiCall::CreateSpriteTemplate:
+							CreateSpriteTemplate(a_reader);
+							break;
+						case ApiCall::DestroySpriteTemplate:
+							m_templates.erase(a_reader.Read<uint8_t>());
+							break;
+						case ApiCall::CreateSprite:
+							CreateSprite(a_reader);
+							break;
+						case ApiCall::DestroySprite:
+							m_sprites.erase(a_reader.Read<uint16_t>());
+							break;
+						case ApiCall::SetSpritePosition: {
+							uint16_t index = a_reader.Read<uint16_t>();
+							m_sprites.at(index).SetPosition(a_reader.Read<glm::vec2>());
+						} break;
+						case ApiCall::SetSpriteColor: {
+							uint16_t index = a_reader.Read<uint16_t>();
+							m_sprites.at(index).SetColor(a_reader.Read<glm::vec4>());
+						} break;
+						case ApiCall::SetSpriteRotation: {
+							uint16_t index = a_reader.Read<uint16_t>();
+							m_sprites.at(index).SetRotation(a_reader.Read<float>());
+						} break;
+						default:
+							Core::Log::Require(false, "corrupt recording, unknown api call at offset {}",
+							                   a_reader.GetOffset() - 1);
+					}
+				}
+			} catch(const ApiRecorder::TruncatedError& a_error) {
+				fmt::print("{}, stopping the replay there\n", a_error.what());
+				complete = false;
+			}
+			// recording ended without a ShutdownEngine, i.e. the game crashed. Still want the numbers up to that point.
+			ShutdownEngine();
+			return complete;
+		}
+
+		[[nodiscard]] const vector<float>& GetFrameMs() const { return m_frameMs; }
+
+	  private:
+		void CreateEngine(ApiRecorder::Reader& a_reader) {
+			// read first, a truncated recording leaves nothing half created.
+			EngineSettings settings = a_reader.ReadSettings();
+
+			glfwInit();
+			glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+			glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+			m_window = glfwCreateWindow(1280, 720, "graphics_replay", nullptr, nullptr);
+
+			settings.ExtensionsToEnable = glfwGetRequiredInstanceExtensions(&settings.ExtensionsToEnableCount);
+			settings.Hwnd               = glfwGetWin32Window(m_window);
+			settings.HInstance          = GetModuleHandle(nullptr);
+			settings.PipelineCachePath  = Platform::GetCurrentProcessPath() / "replay_pipeline.cache";
+			settings.NullBackend        = m_options.NullBackend;
+			Graphics::CreateEngine(settings);
+			m_start = chrono::steady_clock::now();
+		}
+
+		void ShutdownEngine() {
+			// recording could have been cut off before the engine was created.
+			if(m_window == nullptr) { return; }
+			m_sprites.clear();
+			m_templates.clear();
+			m_textureSets.clear();
+			Graphics::ShutdownEngine();
+			glfwDestroyWindow(m_window);
+			glfwTerminate();
+			m_window = nullptr;
+		}
+
+		void Frame(ApiRecorder::Reader& a_reader) {
+			auto recordedTime = chrono::nanoseconds(a_reader.Read<uint64_t>());
+			if(m_options.Paced) { this_thread::sleep_until(m_start + recordedTime); }
+
+			glfwPollEvents();
+			auto start = chrono::steady_clock::now();
+			Graphics::Frame();
+			m_frameMs.push_back(chrono::duration<float, milli>(chrono::steady_clock::now() - start).count());
+		}
+
+		void TextureData(ApiRecorder::Reader& a_reader) {
+			uint32_t id = a_reader.Read<uint32_t>();
+			m_textureData.emplace(id, a_reader.ReadBytes());
+		}
+
+		void CreateTextureSet(ApiRecorder::Reader& a_reader) {
+			uint16_t set   = a_reader.Read<uint16_t>();
+			uint16_t count = a_reader.Read<uint16_t>();
+			vector<TextureCreateInfo> infos(count);
+			for(auto& info : infos) {
+				info.Name        = a_reader.ReadString();
+				info.TextureData = m_textureData.at(a_reader.Read<uint32_t>());
+			}
+			m_textureSets.insert_or_assign(set, TextureSet({infos.data(), infos.size()}));
+		}
+
+		void CreateSpriteTemplate(ApiRecorder::Reader& a_reader) {
+			uint8_t index = a_reader.Read<uint8_t>();
+			SpriteTemplateBasicCreateInfo info;
+			info.Name          = a_reader.ReadString();
+			info.TextureName   = a_reader.ReadString();
+			info.FrameSize     = a_reader.Read<glm::uvec2>();
+			info.FrameRate     = (eFrameRate)a_reader.Read<uint8_t>();
+			info.BlendMode     = (eBlendMode)a_reader.Read<uint8_t>();
+			info.SampleShading = a_reader.Read<bool>();
+			m_templates.insert_or_assign(index, CreateSpriteTemplateBasic(info));
+		}
+
+		void CreateSprite(ApiRecorder::Reader& a_reader) {
+			uint16_t index = a_reader.Read<uint16_t>();
+			SpriteBasicCreateInfo info;
+			info.Name     = a_reader.ReadString();
+			info.Template = m_templates.at(a_reader.Read<uint8_t>());
+			m_sprites.insert_or_assign(index, SpriteBasic(info));
+		}
+
+		Options m_options;
+		GLFWwindow* m_window{nullptr};
+		chrono::steady_clock::time_point m_start;
+		tsl::robin_map<uint32_t, Core::Span<const byte>> m_textureData;
+		// Indices are the ones from the recording, the engine may hand out different ones during the replay.
+		tsl::robin_map<uint16_t, TextureSet> m_textureSets;
+		tsl::robin_map<uint8_t, shared_ptr<SpriteTemplateBasic>> m_templates;
+		tsl::robin_map<uint16_t, SpriteBasic> m_sprites;
+		vector<float> m_frameMs;
+	};
+
+	float Percentile(const vector<float>& a_sorted, float a_percentile) {
+		if(a_sorted.empty()) { return 0.0f; }
+		return a_sorted[std::min(a_sorted.size() - 1, (size_t)(a_percentile * a_sorted.size()))];
+	}
+}    // namespace
+
+// Re-drives the engine from a file recorded with EngineSettings::RecordPath. Meant for running a captured session
+// under a profiler. The window is always 1280x720.
+int main(int argc, char** argv) {
+	Options options;
+	filesystem::path path;
+	for(int i = 1; i < argc; ++i) {
+		if(strcmp(argv[i], "--null") == 0) {
+			options.NullBackend = true;
+		} else if(strcmp(argv[i], "--paced") == 0) {
+			options.Paced = true;
+		} else if(argv[i][0] != '-' && path.empty()) {
+			path = argv[i];
+		} else {
+			fmt::print("graphics_replay <recording> [options]\n"
+			           "  --paced  keep to the recorded frame times, instead of replaying as fast as possible\n"
+			           "  --null   no gpu, only replays the cpu side of the engine\n");
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+	if(path.empty()) {
+		fmt::print("graphics_replay <recording> [options], --help for options\n");
+		return 1;
+	}
+
+	Platform::MemoryMappedFile file(path);
+	ApiRecorder::Reader reader({file.data(), file.size()});
+
+	Replay replay(options);
+	bool complete = replay.Run(reader);
+
+	vector<float> sorted = replay.GetFrameMs();
+	sort(begin(sorted), end(sorted));
+	fmt::print("{} frames, p50 {:.3f}ms p90 {:.3f}ms p99 {:.3f}ms max {:.3f}ms\n", sorted.size(),
+	           Percentile(sorted, 0.5f), Percentile(sorted, 0.9f), Percentile(sorted, 0.99f),
+	           sorted.empty() ? 0.0f : sorted.back());
+	return complete ? 0 : 1;
+}
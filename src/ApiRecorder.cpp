@@ -0,0 +1,279 @@
+﻿#include "ApiRecorder.h"
+
+#include "core/BinaryStream.h"
+#include "core/Log.h"
+
+#include <3rdParty/robinmap.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	struct RecordedTexture {
+		uint32_t ID{0};
+		uint32_t Size{0};
+		uint64_t FileOffset{0};    // of the crtex data itself
+	};
+
+	bool g_recording{false};
+	filesystem::path g_path;
+	ofstream g_file;
+	uint64_t g_fileSize{0};
+	// records for the current frame, written out at the start of the next one.
+	vector<byte> g_buffer;
+	chrono::steady_clock::time_point g_start;
+	// crtex files already written, by a hash of their contents. Games tend to load the same sets over and over.
+	tsl::robin_map<size_t, vector<RecordedTexture>> g_textureData;
+	uint32_t g_nextTextureID{0};
+
+	void WriteCall(ApiRecorder::ApiCall a_call) {
+		Core::Write(g_buffer, a_call);
+	}
+
+	void WriteString(const string& a_string) {
+		Core::Log::Assert(a_string.size() <= numeric_limits<uint16_t>::max(), "string too long to record {}", a_string);
+		Core::Write(g_buffer, (uint16_t)a_string.size());
+		g_buffer.insert(end(g_buffer), (const byte*)a_string.data(), (const byte*)a_string.data() + a_string.size());
+	}
+
+	// Reader::ReadSettings must read these back in the same order.
+	void WriteSettings(const EngineSettings& a_settings) {
+		WriteString(a_settings.ApplicationName);
+		Core::Write(g_buffer, a_settings.ApplicationVersion);
+		Core::Write(g_buffer, a_settings.EnableDebug);
+		Core::Write(g_buffer, a_settings.ClearColor.has_value());
+		Core::Write(g_buffer, a_settings.ClearColor.value_or(glm::vec4{0.0f}));
+		Core::Write(g_buffer, a_settings.RefreshRate);
+		Core::Write(g_buffer, (uint8_t)a_settings.PresentationMode);
+		Core::Write(g_buffer, a_settings.SwapChainImages);
+		Core::Write(g_buffer, a_settings.FrameLimit);
+		Core::Write(g_buffer, a_settings.MsaaSamples);
+		Core::Write(g_buffer, a_settings.SampleShading);
+		Core::Write(g_buffer, a_settings.ReuseDrawCommands);
+		Core::Write(g_buffer, a_settings.SkipUnchangedFrames);
+		Core::Write(g_buffer, a_settings.PoolHostAllocations);
+	}
+
+	// All the way to the os, not just into the ofstream's buffer.
+	void Flush() {
+		g_file.write((const char*)g_buffer.data(), g_buffer.size());
+		g_file.flush();
+		g_fileSize += g_buffer.size();
+		g_buffer.clear();
+	}
+
+	// A hash match isn't proof, compares against the copy already in the file. Reading it back keeps memory flat,
+	// rather than holding on to every texture recorded, and only happens when a texture is loaded again.
+	bool IsRecorded(const RecordedTexture& a_recorded, const Core::Span<const byte>& a_data) {
+		if(a_recorded.Size != a_data.size()) { return false; }
+		Flush();
+
+		ifstream file(g_path, ios::binary);
+		file.seekg(a_recorded.FileOffset);
+		constexpr size_t c_chunkSize = 64 * 1024;
+		vector<byte> chunk(c_chunkSize);
+		for(size_t offset = 0; offset < a_data.size(); offset += c_chunkSize) {
+			size_t size = std::min(c_chunkSize, a_data.size() - offset);
+			file.read((char*)chunk.data(), size);
+			if(!file || memcmp(chunk.data(), a_data.data() + offset, size) != 0) { return false; }
+		}
+		return true;
+	}
+
+	uint32_t WriteTextureData(const Core::Span<const byte>& a_data) {
+		size_t hash   = std::hash<string_view>{}(string_view((const char*)a_data.data(), a_data.size()));
+		auto& matches = g_textureData[hash];
+		for(const auto& recorded : matches) {
+			if(IsRecorded(recorded, a_data)) { return recorded.ID; }
+		}
+
+		RecordedTexture& recorded = matches.emplace_back();
+		recorded.ID               = g_nextTextureID++;
+		recorded.Size             = (uint32_t)a_data.size();
+		WriteCall(ApiRecorder::ApiCall::TextureData);
+		Core::Write(g_buffer, recorded.ID);
+		Core::Write(g_buffer, recorded.Size);
+		recorded.FileOffset = g_fileSize + g_buffer.size();
+		g_buffer.insert(end(g_buffer), a_data.data(), a_data.data() + a_data.size());
+		return recorded.ID;
+	}
+}    // namespace
+
+void ApiRecorder::Start(const filesystem::path& a_path, const EngineSettings& a_settings) {
+	g_file.open(a_path, ios::binary | ios::trunc);
+	if(!g_file) {
+		Core::Log::Warn("Failed to open {} for recording, api calls won't be recorded", a_path.string());
+		return;
+	}
+	g_recording = true;
+	g_path      = a_path;
+	g_fileSize  = 0;
+	g_start     = chrono::steady_clock::now();
+	g_textureData.clear();
+	g_nextTextureID = 0;
+
+	Core::Write(g_buffer, Header{});
+	WriteCall(ApiCall::CreateEngine);
+	WriteSettings(a_settings);
+	Flush();
+}
+
+void ApiRecorder::Stop() {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::ShutdownEngine);
+	Flush();
+	g_file.close();
+	g_recording = false;
+}
+
+void ApiRecorder::Frame() {
+	if(!g_recording) { return; }
+	// writing out the previous frame's records here, rather than buffering the whole session, keeps memory flat and
+	// means a crash only loses a frame.
+	Flush();
+	WriteCall(ApiCall::Frame);
+	Core::Write(g_buffer,
+	            (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - g_start).count());
+}
+
+void ApiRecorder::WindowResized() {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::WindowResized);
+}
+
+void ApiRecorder::CreateTextureSet(uint16_t a_set, const Core::Span<TextureCreateInfo> a_textures) {
+	if(!g_recording) { return; }
+	vector<uint32_t> dataIds;
+	dataIds.reserve(a_textures.size());
+	for(uint32_t i = 0; i < a_textures.size(); ++i) { dataIds.push_back(WriteTextureData(a_textures[i].TextureData)); }
+
+	WriteCall(ApiCall::CreateTextureSet);
+	Core::Write(g_buffer, a_set);
+	Core::Write(g_buffer, (uint16_t)a_textures.size());
+	for(uint32_t i = 0; i < a_textures.size(); ++i) {
+		WriteString(a_textures[i].Name);
+		Core::Write(g_buffer, dataIds[i]);
+	}
+}
+
+void ApiRecorder::DestroyTextureSet(uint16_t a_set) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::DestroyTextureSet);
+	Core::Write(g_buffer, a_set);
+}
+
+void ApiRecorder::CreateSpriteTemplate(uint8_t a_template, const SpriteTemplateBasicCreateInfo& a_info) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::CreateSpriteTemplate);
+	Core::Write(g_buffer, a_template);
+	WriteString(a_info.Name);
+	WriteString(a_info.TextureName);
+	Core::Write(g_buffer, a_info.FrameSize);
+	Core::Write(g_buffer, (uint8_t)a_info.FrameRate);
+	Core::Write(g_buffer, (uint8_t)a_info.BlendMode);
+	Core::Write(g_buffer, a_info.SampleShading);
+}
+
+void ApiRecorder::DestroySpriteTemplate(uint8_t a_template) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::DestroySpriteTemplate);
+	Core::Write(g_buffer, a_template);
+}
+
+void ApiRecorder::CreateSprite(uint16_t a_sprite, const string& a_name, uint8_t a_template) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::CreateSprite);
+	Core::Write(g_buffer, a_sprite);
+	WriteString(a_name);
+	Core::Write(g_buffer, a_template);
+}
+
+void ApiRecorder::DestroySprite(uint16_t a_sprite) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::DestroySprite);
+	Core::Write(g_buffer, a_sprite);
+}
+
+void ApiRecorder::SetSpritePosition(uint16_t a_sprite, const glm::vec2& a_position) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::SetSpritePosition);
+	Core::Write(g_buffer, a_sprite);
+	Core::Write(g_buffer, a_position);
+}
+
+void ApiRecorder::SetSpriteColor(uint16_t a_sprite, const glm::vec4& a_color) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::SetSpriteColor);
+	Core::Write(g_buffer, a_sprite);
+	Core::Write(g_buffer, a_color);
+}
+
+void ApiRecorder::SetSpriteRotation(uint16_t a_sprite, float a_rotation) {
+	if(!g_recording) { return; }
+	WriteCall(ApiCall::SetSpriteRotation);
+	Core::Write(g_buffer, a_sprite);
+	Core::Write(g_buffer, a_rotation);
+}
+
+ApiRecorder::Reader::Reader(Core::Span<const byte> a_data) {
+	Core::Log::Require(a_data.size() <= numeric_limits<uint32_t>::max(), "recordings over 4GB aren't supported");
+	m_reader.Data   = a_data.data();
+	m_reader.Offset = 0;
+	m_reader.Size   = (uint32_t)a_data.size();
+	Core::Log::Require(a_data.size() >= sizeof(Header), "not an api recording");
+	auto header = Read<Header>();
+	Core::Log::Require(header.FourCC == Header::c_FourCC, "not an api recording");
+	Core::Log::Require(header.Version == Header::c_Version, "api recording is from a different version of the engine");
+}
+
+EngineSettings ApiRecorder::Reader::ReadSettings() {
+	EngineSettings settings;
+	settings.ApplicationName    = ReadString();
+	settings.ApplicationVersion = Read<uint32_t>();
+	settings.EnableDebug        = Read<bool>();
+	bool hasClearColor          = Read<bool>();
+	auto clearColor             = Read<glm::vec4>();
+	if(hasClearColor) { settings.ClearColor = clearColor; }
+	settings.RefreshRate         = Read<uint32_t>();
+	settings.PresentationMode    = (PresentMode)Read<uint8_t>();
+	settings.SwapChainImages     = Read<uint32_t>();
+	settings.FrameLimit          = Read<uint32_t>();
+	settings.MsaaSamples         = Read<uint32_t>();
+	settings.SampleShading       = Read<bool>();
+	settings.ReuseDrawCommands   = Read<bool>();
+	settings.SkipUnchangedFrames = Read<bool>();
+	settings.PoolHostAllocations = Read<bool>();
+	return settings;
+}
+
+string ApiRecorder::Reader::ReadString() {
+	auto size = Read<uint16_t>();
+	CheckRemaining(size);
+	string result((const char*)m_reader.Data + m_reader.Offset, size);
+	m_reader.Offset += size;
+	return result;
+}
+
+Core::Span<const byte> ApiRecorder::Reader::ReadBytes() {
+	auto size = Read<uint32_t>();
+	CheckRemaining(size);
+	Core::Span<const byte> result(m_reader.Data + m_reader.Offset, size);
+	m_reader.Offset += size;
+	return result;
+}
+
+void ApiRecorder::Reader::CheckRemaining(uint32_t a_size) const {
+	if(m_reader.Offset > m_reader.Size || m_reader.Size - m_reader.Offset < a_size) {
+		throw TruncatedError(fmt::format("api recording is truncated, needed {} bytes at offset {} of {}", a_size,
+		                                 m_reader.Offset, m_reader.Size));
+	}
+}
@@ -0,0 +1,105 @@
+﻿#pragma once
+
+#include "Graphics/Engine.h"
+#include "Graphics/SpriteBasic.h"
+#include "Graphics/TextureSet.h"
+
+#include "core/BinaryStream.h"
+#include "core/Span.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+// Records calls to the public api into a compact binary file, for replaying a session later with graphics_replay.
+// Started by EngineSettings::RecordPath. Only records what the engine is asked to do, the application's own timing and
+// reactions to it(i.e. loaded callbacks) aren't captured. Render thread only, like the api itself. Each function does
+// nothing if not recording.
+namespace CR::Graphics::ApiRecorder {
+	// File is a Header, followed by records. Each record is an ApiCall, then its arguments. Strings are a uint16_t
+	// length then the characters, byte arrays a uint32_t length then the bytes. Everything else is written as is.
+#pragma pack(1)
+	struct Header {
+		static constexpr uint32_t c_FourCC{'CRAR'};
+		static constexpr uint32_t c_Version{2};
+		uint32_t FourCC{c_FourCC};
+		uint16_t Version{c_Version};
+	};
+#pragma pack()
+
+	// CreateEngine only has the settings that affect performance, in this order: string ApplicationName, uint32_t
+	// ApplicationVersion, bool EnableDebug, bool has ClearColor, glm::vec4 ClearColor, uint32_t RefreshRate, uint8_t
+	// PresentationMode, uint32_t SwapChainImages, uint32_t FrameLimit, uint32_t MsaaSamples, bool SampleShading,
+	// bool ReuseDrawCommands, bool SkipUnchangedFrames, bool PoolHostAllocations.
+	enum class ApiCall : uint8_t {
+		CreateEngine,             //
+		ShutdownEngine,           //
+		Frame,                    // uint64_t nanoseconds since CreateEngine
+		WindowResized,            //
+		TextureData,              // uint32_t id, byte array. Written once per unique crtex file.
+		CreateTextureSet,         // uint16_t set, uint16_t count, then count*(string name, uint32_t texture data id)
+		DestroyTextureSet,        // uint16_t set
+		CreateSpriteTemplate,     // uint8_t template, string name, string texture, glm::uvec2 frame size, uint8_t rate,
+		                          // uint8_t blend mode, bool sample shading
+		DestroySpriteTemplate,    // uint8_t template
+		CreateSprite,             // uint16_t sprite, string name, uint8_t template
+		DestroySprite,            // uint16_t sprite
+		SetSpritePosition,        // uint16_t sprite, glm::vec2
+		SetSpriteColor,           // uint16_t sprite, glm::vec4
+		SetSpriteRotation,        // uint16_t sprite, float
+	};
+
+	void Start(const std::filesystem::path& a_path, const EngineSettings& a_settings);
+	// Records ShutdownEngine and closes the file.
+	void Stop();
+
+	void Frame();
+	void WindowResized();
+	void CreateTextureSet(uint16_t a_set, const Core::Span<TextureCreateInfo> a_textures);
+	void DestroyTextureSet(uint16_t a_set);
+	void CreateSpriteTemplate(uint8_t a_template, const SpriteTemplateBasicCreateInfo& a_info);
+	void DestroySpriteTemplate(uint8_t a_template);
+	void CreateSprite(uint16_t a_sprite, const std::string& a_name, uint8_t a_template);
+	void DestroySprite(uint16_t a_sprite);
+	void SetSpritePosition(uint16_t a_sprite, const glm::vec2& a_position);
+	void SetSpriteColor(uint16_t a_sprite, const glm::vec4& a_color);
+	void SetSpriteRotation(uint16_t a_sprite, float a_rotation);
+
+	// Thrown by Reader when a record runs past the end of the data, i.e. the recording was cut off by a crash.
+	class TruncatedError : public std::runtime_error {
+	  public:
+		using std::runtime_error::runtime_error;
+	};
+
+	// Reads a recording back, a call at a time. After ReadCall, read that call's arguments in the order listed in
+	// ApiCall. Spans point into a_data, which must outlive them. Every read is bounds checked, throws TruncatedError
+	// rather than reading past the end.
+	class Reader {
+	  public:
+		// Fails if a_data isn't a recording from this version of the engine.
+		explicit Reader(Core::Span<const std::byte> a_data);
+
+		[[nodiscard]] bool AtEnd() const { return m_reader.Offset >= m_reader.Size; }
+		[[nodiscard]] uint32_t GetOffset() const { return m_reader.Offset; }
+
+		[[nodiscard]] ApiCall ReadCall() { return Read<ApiCall>(); }
+		// CreateEngine's arguments. Anything not recorded, i.e. the window, is left at its default.
+		[[nodiscard]] EngineSettings ReadSettings();
+		[[nodiscard]] std::string ReadString();
+		[[nodiscard]] Core::Span<const std::byte> ReadBytes();
+
+		template<typename T>
+		[[nodiscard]] T Read() {
+			CheckRemaining(sizeof(T));
+			T result;
+			Core::Read(m_reader, result);
+			return result;
+		}
+
+	  private:
+		void CheckRemaining(uint32_t a_size) const;
+
+		Core::BinaryReader m_reader;
+	};
+}    // namespace CR::Graphics::ApiRecorder
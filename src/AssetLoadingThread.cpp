@@ -2,6 +2,8 @@
 
 #include "CommandPool.h"
 #include "EngineInternal.h"
+#include "FrameCounters.h"
+#include "Trace.h"
 
 #include <deque>
 #include <future>
@@ -39,6 +41,7 @@ namespace {
 					return cmdBuffer;
 				};
 				auto submit = [&]() {
+					CR_TRACE_SCOPE("TransferSubmit");
 					cmdBuffer.End();
 
 					vk::SubmitInfo subInfo;
@@ -48,9 +51,12 @@ namespace {
 					GetTransferQueue().waitIdle();
 				};
 
+				CR_TRACE_SCOPE("LoadAsset");
 				request(getCmdBuffer, submit);
+				FrameCounters::AddPendingAssetLoads(-1);
 			}
 		}
+		FrameCounters::AddPendingAssetLoads(-(int32_t)m_requests.size());
 		m_requests.clear();
 	}
 }    // namespace
@@ -66,18 +72,11 @@ void AssetLoadingThread::Shutdown() {
 	m_thread.join();
 }
 
-std::shared_ptr<std::atomic_bool> AssetLoadingThread::LoadAsset(task_t&& a_task) {
-	std::shared_ptr<std::atomic_bool> result = make_shared<std::atomic_bool>(false);
-
-	task_t wrappedTask = [result = result, task = move(a_task)](fu2::unique_function<CommandBuffer&()> getCmdBuffer,
-	                                                            fu2::unique_function<void()> submit) mutable {
-		task(move(getCmdBuffer), move(submit));
-		result->store(true, memory_order_release);
-	};
+void AssetLoadingThread::LoadAsset(task_t&& a_task) {
+	FrameCounters::AddPendingAssetLoads(1);
 	{
 		unique_lock<mutex> lock(m_requestMutex);
-		m_requests.push_back(move(wrappedTask));
+		m_requests.push_back(move(a_task));
 	}
 	m_notify.notify_one();
-	return result;
 }
@@ -13,12 +13,13 @@ namespace CR::Graphics {
 
 namespace CR::Graphics::AssetLoadingThread {
 	// First function passed to you will acquire a command buffer, the second function will perform the work you have
-	// given in the command buffer, and then wait for that work to be 100% completed
+	// given in the command buffer, and then wait for that work to be 100% completed. There is no completion handle,
+	// tasks should report their own completion, i.e. TextureSets pushes to its completion queue.
 	using task_t = fu2::unique_function<void(fu2::unique_function<CommandBuffer&()>, fu2::unique_function<void()>)>;
 
 	void Init();
 	void Shutdown();
 
-	std::shared_ptr<std::atomic_bool> LoadAsset(task_t&& a_task);
+	void LoadAsset(task_t&& a_task);
 
 }    // namespace CR::Graphics::AssetLoadingThread
@@ -1,5 +1,10 @@
 ﻿#include "CommandPool.h"
 
+#include "FrameCounters.h"
+#include "HostAllocator.h"
+
+#include "core/Log.h"
+
 using namespace CR::Graphics;
 using namespace std;
 
@@ -21,19 +26,24 @@ CommandPool::CommandPool(CommandPool::PoolType a_type) : m_Type(a_type) {
 		default:
 			break;
 	}
-	m_CommandPool = GetDevice().createCommandPool(info);
+	m_CommandPool = GetDevice().createCommandPool(info, HostAllocator::Get());
 }
 
 CommandPool::~CommandPool() {
-	if(m_Type != PoolType::Invalid) { GetDevice().destroyCommandPool(m_CommandPool); }
+	// free list is freed along with the pool
+	if(m_Type != PoolType::Invalid) { GetDevice().destroyCommandPool(m_CommandPool, HostAllocator::Get()); }
 	m_Type = PoolType::Invalid;
+	m_freeBuffers.clear();
 }
 
 CommandPool& CommandPool::operator=(CommandPool&& a_other) noexcept {
+	Core::Log::Assert(m_outstanding == 0 && a_other.m_outstanding == 0,
+	                  "CommandPool moved while it has outstanding command buffers");
 	this->~CommandPool();
 
 	m_Type        = a_other.m_Type;
 	m_CommandPool = a_other.m_CommandPool;
+	m_freeBuffers = move(a_other.m_freeBuffers);
 
 	a_other.m_Type = PoolType::Invalid;
 
@@ -41,20 +51,39 @@ CommandPool& CommandPool::operator=(CommandPool&& a_other) noexcept {
 }
 
 CommandBuffer CommandPool::CreateCommandBuffer() {
+	// Pools are created with eResetCommandBuffer, so Begin resets a recycled buffer if the pool hasn't been reset.
+	if(!m_freeBuffers.empty()) {
+		vk::CommandBuffer buffer = m_freeBuffers.back();
+		m_freeBuffers.pop_back();
+		++m_outstanding;
+		return CommandBuffer(*this, buffer);
+	}
+
 	vk::CommandBufferAllocateInfo info;
 	info.commandBufferCount = 1;
 	info.commandPool        = m_CommandPool;
 	info.level = m_Type == PoolType::Secondary ? vk::CommandBufferLevel::eSecondary : vk::CommandBufferLevel::ePrimary;
 	vk::CommandBuffer buffer;
 	buffer = GetDevice().allocateCommandBuffers(info)[0];
-	return CommandBuffer(m_CommandPool, buffer);
+	FrameCounters::AddCommandBufferAllocated();
+	++m_outstanding;
+	return CommandBuffer(*this, buffer);
+}
+
+void CommandPool::Reset() {
+	GetDevice().resetCommandPool(m_CommandPool, vk::CommandPoolResetFlags{});
 }
 
-CommandBuffer::CommandBuffer(vk::CommandPool& commandPool, const vk::CommandBuffer& buffer) :
+void CommandPool::Recycle(const vk::CommandBuffer& a_buffer) {
+	m_freeBuffers.push_back(a_buffer);
+	--m_outstanding;
+}
+
+CommandBuffer::CommandBuffer(CommandPool& commandPool, const vk::CommandBuffer& buffer) :
     m_CommandPool(&commandPool), m_Buffer(buffer) {}
 
 CommandBuffer::~CommandBuffer() {
-	if(m_CommandPool != nullptr) { GetDevice().freeCommandBuffers(*m_CommandPool, 1, &m_Buffer); }
+	if(m_CommandPool != nullptr) { m_CommandPool->Recycle(m_Buffer); }
 	m_CommandPool = nullptr;
 }
 
@@ -74,6 +103,14 @@ void CommandBuffer::Begin() {
 	m_Buffer.begin(info);
 }
 
+void CommandBuffer::Begin(const vk::CommandBufferInheritanceInfo& a_inheritance, bool a_oneTimeSubmit) {
+	vk::CommandBufferBeginInfo info;
+	info.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+	if(a_oneTimeSubmit) { info.flags |= vk::CommandBufferUsageFlagBits::eOneTimeSubmit; }
+	info.pInheritanceInfo = &a_inheritance;
+	m_Buffer.begin(info);
+}
+
 void CommandBuffer::End() {
 	m_Buffer.end();
 }
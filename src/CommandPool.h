@@ -3,12 +3,17 @@
 #include "EngineInternal.h"
 
 #include <memory>
+#include <vector>
 
 namespace CR::Graphics {
+	class CommandPool;
+
+	// Destroying a CommandBuffer hands it back to its pool for reuse, it is not freed. It must not be pending on the
+	// gpu by then.
 	class CommandBuffer {
 	  public:
 		CommandBuffer() = default;
-		CommandBuffer(vk::CommandPool& commandPool, const vk::CommandBuffer& buffer);
+		CommandBuffer(CommandPool& commandPool, const vk::CommandBuffer& buffer);
 		~CommandBuffer();
 		CommandBuffer(const CommandBuffer&) = delete;
 		CommandBuffer(CommandBuffer&& a_other) noexcept;
@@ -17,14 +22,19 @@ namespace CR::Graphics {
 
 		[[nodiscard]] vk::CommandBuffer& GetHandle();
 		void Begin();
+		// For secondary command buffers that continue a render pass. Only pass false for a_oneTimeSubmit if the buffer
+		// will be executed again without re-recording.
+		void Begin(const vk::CommandBufferInheritanceInfo& a_inheritance, bool a_oneTimeSubmit);
 		void End();
 		void Reset();
 
 	  private:
-		vk::CommandPool* m_CommandPool = nullptr;
+		CommandPool* m_CommandPool = nullptr;
 		vk::CommandBuffer m_Buffer;
 	};
 
+	// Not thread safe, use one pool per thread. CommandBuffers point back at their pool, so it can only be moved while
+	// none are outstanding.
 	class CommandPool {
 	  public:
 		// Primary and secondary will be on the graphics queue. Transfer will be on the transfer queue.
@@ -39,12 +49,22 @@ namespace CR::Graphics {
 		CommandPool& operator=(const CommandPool&) = delete;
 		CommandPool& operator                      =(CommandPool&& a_other) noexcept;
 
-		// If the command pool is destroyed, any command buffers returned here will no longer work.
+		// If the command pool is destroyed, any command buffers returned here will no longer work. Reuses a previously
+		// destroyed CommandBuffer when there is one, only allocates from the driver when there isn't.
 		[[nodiscard]] CommandBuffer CreateCommandBuffer();
+		// Resets every command buffer from this pool at once, cheaper than resetting them individually. Nothing from
+		// this pool can be pending on the gpu. Keeps the pool's memory around for the next round of recording.
+		void Reset();
 
 	  private:
+		friend class CommandBuffer;
+		void Recycle(const vk::CommandBuffer& a_buffer);
+
 		PoolType m_Type = PoolType::Invalid;
 		vk::CommandPool m_CommandPool;
+		std::vector<vk::CommandBuffer> m_freeBuffers;
+		// CommandBuffers created and not yet destroyed.
+		uint32_t m_outstanding{0};
 	};
 
 	inline CommandBuffer::CommandBuffer(CommandBuffer&& a_other) noexcept { *this = std::move(a_other); }
@@ -1,13 +1,15 @@
 ﻿#include "Commands.h"
 
 #include "EngineInternal.h"
+#include "FrameCounters.h"
 
 #include "VulkanWindows.h"
 
 using namespace CR::Graphics;
 using namespace std;
 
-void Commands::RenderPassBegin(CommandBuffer& a_cmdBuffer, std::optional<glm::vec4> a_clearColor) {
+void Commands::RenderPassBegin(CommandBuffer& a_cmdBuffer, std::optional<glm::vec4> a_clearColor,
+                               vk::SubpassContents a_contents) {
 	vk::RenderPassBeginInfo renderPassInfo;
 	renderPassInfo.renderPass               = GetRenderPass();
 	renderPassInfo.renderArea.extent.width  = GetWindowSize().x;
@@ -25,7 +27,30 @@ void Commands::RenderPassBegin(CommandBuffer& a_cmdBuffer, std::optional<glm::ve
 	}
 
 	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
-	vkcmd.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+	vkcmd.beginRenderPass(renderPassInfo, a_contents);
+
+	if(a_contents == vk::SubpassContents::eInline) { SetViewport(a_cmdBuffer, GetWindowSize()); }
+}
+
+void Commands::SetViewport(CommandBuffer& a_cmdBuffer, const glm::ivec2& a_windowSize) {
+	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
+
+	vk::Viewport viewPort;
+	viewPort.width    = (float)a_windowSize.x;
+	viewPort.height   = (float)a_windowSize.y;
+	viewPort.minDepth = 0.0f;
+	viewPort.maxDepth = 1.0f;
+	vkcmd.setViewport(0, 1, &viewPort);
+
+	vk::Rect2D scissor;
+	scissor.extent.width  = a_windowSize.x;
+	scissor.extent.height = a_windowSize.y;
+	vkcmd.setScissor(0, 1, &scissor);
+}
+
+void Commands::ExecuteCommands(CommandBuffer& a_cmdBuffer, CR::Core::Span<const vk::CommandBuffer> a_secondaries) {
+	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
+	vkcmd.executeCommands((uint32_t)a_secondaries.size(), a_secondaries.data());
 }
 
 void Commands::RenderPassEnd(CommandBuffer& a_cmdBuffer) {
@@ -38,9 +63,14 @@ void Commands::BindPipeline(CommandBuffer& a_cmdBuffer, Pipeline& a_pipeline) {
 	vkcmd.bindPipeline(vk::PipelineBindPoint::eGraphics, a_pipeline.GetHandle());
 }
 
-void Commands::BindVertexBuffer(CommandBuffer& a_cmdBuffer, const vk::Buffer& a_buffer) {
+void Commands::BindPipeline(CommandBuffer& a_cmdBuffer, const Pipeline& a_pipeline, const PipelineVariant& a_variant) {
 	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
-	vkcmd.bindVertexBuffers(0, {a_buffer}, {0});
+	vkcmd.bindPipeline(vk::PipelineBindPoint::eGraphics, a_pipeline.GetHandle(a_variant));
+}
+
+void Commands::BindVertexBuffer(CommandBuffer& a_cmdBuffer, const vk::Buffer& a_buffer, vk::DeviceSize a_offset) {
+	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
+	vkcmd.bindVertexBuffers(0, {a_buffer}, {a_offset});
 }
 
 void Commands::PushConstants(CommandBuffer& a_cmdBuffer, Pipeline& a_pipeline, CR::Core::Span<std::byte> a_data) {
@@ -49,9 +79,10 @@ void Commands::PushConstants(CommandBuffer& a_cmdBuffer, Pipeline& a_pipeline, C
 	                    a_data.data());
 }
 
-void Commands::Draw(CommandBuffer& a_cmdBuffer, uint32_t a_vertexCount, uint32_t a_instanceCount) {
+void Commands::Draw(CommandBuffer& a_cmdBuffer, uint32_t a_vertexCount, uint32_t a_instanceCount,
+                     uint32_t a_firstInstance) {
 	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
-	vkcmd.draw(a_vertexCount, a_instanceCount, 0, 0);
+	vkcmd.draw(a_vertexCount, a_instanceCount, 0, a_firstInstance);
 }
 
 void Commands::BindDescriptorSet(CommandBuffer& a_cmdBuffer, const Pipeline& a_pipeline, vk::DescriptorSet& a_set) {
@@ -59,6 +90,13 @@ void Commands::BindDescriptorSet(CommandBuffer& a_cmdBuffer, const Pipeline& a_p
 	vkcmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, a_pipeline.GetLayout(), 0, 1, &a_set, 0, nullptr);
 }
 
+void Commands::BindDescriptorSet(CommandBuffer& a_cmdBuffer, const Pipeline& a_pipeline, vk::DescriptorSet& a_set,
+                                 uint32_t a_dynamicOffset) {
+	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
+	vkcmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, a_pipeline.GetLayout(), 0, 1, &a_set, 1,
+	                         &a_dynamicOffset);
+}
+
 void Commands::TransitionToDst(CommandBuffer& a_cmdBuffer, const vk::Image& a_image, uint32_t a_layerCount) {
 	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
 
@@ -144,15 +182,16 @@ void Commands::TransitionFromTransferQueue(CommandBuffer& a_cmdBuffer, const vk:
 }
 
 void Commands::CopyBufferToBuffer(CommandBuffer& a_cmdBuffer, const vk::Buffer& a_bufferSrc, vk::Buffer& a_bufferDst,
-                                  uint32_t a_size) {
+                                  vk::DeviceSize a_offset, uint32_t a_size) {
 	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
 
 	vk::BufferCopy cpy;
-	cpy.srcOffset = 0;
-	cpy.dstOffset = 0;
+	cpy.srcOffset = a_offset;
+	cpy.dstOffset = a_offset;
 	cpy.size      = a_size;
 
 	vkcmd.copyBuffer(a_bufferSrc, a_bufferDst, cpy);
+	FrameCounters::AddBytesUploaded(a_size);
 }
 
 void Commands::SetEvent(CommandBuffer& a_cmdBuffer, const vk::Event& a_event) {
@@ -170,3 +209,8 @@ void Commands::WaitEvent(CommandBuffer& a_cmdBuffer, const vk::Event& a_event) {
 	vkcmd.waitEvents(a_event, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput, memBarrier,
 	                 nullptr, nullptr);
 }
+
+void Commands::ResetEvent(CommandBuffer& a_cmdBuffer, const vk::Event& a_event) {
+	vk::CommandBuffer& vkcmd = a_cmdBuffer.GetHandle();
+	vkcmd.resetEvent(a_event, vk::PipelineStageFlagBits::eVertexInput);
+}
@@ -8,13 +8,24 @@
 #include <optional>
 
 namespace CR::Graphics::Commands {
-	void RenderPassBegin(CommandBuffer& a_cmdBuffer, std::optional<glm::vec4> a_clearColor);
+	// With eInline also sets the viewport and scissor. With eSecondaryCommandBuffers each secondary must set its own.
+	void RenderPassBegin(CommandBuffer& a_cmdBuffer, std::optional<glm::vec4> a_clearColor,
+	                     vk::SubpassContents a_contents);
+	// Viewport and scissor covering the whole window. Size is passed in, so recording threads don't read engine state.
+	void SetViewport(CommandBuffer& a_cmdBuffer, const glm::ivec2& a_windowSize);
+	void ExecuteCommands(CommandBuffer& a_cmdBuffer, CR::Core::Span<const vk::CommandBuffer> a_secondaries);
 	void RenderPassEnd(CommandBuffer& a_cmdBuffer);
 	void BindPipeline(CommandBuffer& a_cmdBuffer, Pipeline& a_pipeline);
-	void BindVertexBuffer(CommandBuffer& a_cmdBuffer, const vk::Buffer& a_buffer);
+	// Variant must be ready.
+	void BindPipeline(CommandBuffer& a_cmdBuffer, const Pipeline& a_pipeline, const PipelineVariant& a_variant);
+	void BindVertexBuffer(CommandBuffer& a_cmdBuffer, const vk::Buffer& a_buffer, vk::DeviceSize a_offset);
 	void BindDescriptorSet(CommandBuffer& a_cmdBuffer, const Pipeline& a_pipeline, vk::DescriptorSet& a_set);
+	// For sets with a single eUniformBufferDynamic binding, i.e. a chunk from a UniformBufferRing.
+	void BindDescriptorSet(CommandBuffer& a_cmdBuffer, const Pipeline& a_pipeline, vk::DescriptorSet& a_set,
+	                       uint32_t a_dynamicOffset);
 	void PushConstants(CommandBuffer& a_cmdBuffer, Pipeline& a_pipeline, CR::Core::Span<std::byte> a_data);
-	void Draw(CommandBuffer& a_cmdBuffer, uint32_t a_vertexCount, uint32_t a_instanceCount);
+	void Draw(CommandBuffer& a_cmdBuffer, uint32_t a_vertexCount, uint32_t a_instanceCount,
+	          uint32_t a_firstInstance = 0);
 
 	void TransitionToDst(CommandBuffer& a_cmdBuffer, const vk::Image& a_image, uint32_t a_layerCount);
 	void CopyBufferToImg(CommandBuffer& a_cmdBuffer, const vk::Buffer& a_buffer, vk::Image& a_image,
@@ -22,10 +33,13 @@ namespace CR::Graphics::Commands {
 	void TransitionToGraphicsQueue(CommandBuffer& a_cmdBuffer, const vk::Image& a_image, uint32_t a_layerCount);
 	void TransitionFromTransferQueue(CommandBuffer& a_cmdBuffer, const vk::Image& a_image, uint32_t a_layerCount);
 
+	// Same offset in both buffers.
 	void CopyBufferToBuffer(CommandBuffer& a_cmdBuffer, const vk::Buffer& a_bufferSrc, vk::Buffer& a_bufferDst,
-	                        uint32_t a_size);
+	                        vk::DeviceSize a_offset, uint32_t a_size);
 
 	void SetEvent(CommandBuffer& a_cmdBuffer, const vk::Event& a_event);
 	void WaitEvent(CommandBuffer& a_cmdBuffer, const vk::Event& a_event);
+	// Once the vertex input stage is past its WaitEvent, so the event can be set again by a later frame.
+	void ResetEvent(CommandBuffer& a_cmdBuffer, const vk::Event& a_event);
 
 }    // namespace CR::Graphics::Commands
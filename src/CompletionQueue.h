@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace CR::Graphics {
+	// Lock free single producer, single consumer queue. Push must only ever be called from one thread, and Pop/Empty
+	// from one other thread. Fixed capacity, Push fails if the queue is full.
+	template<typename T, uint32_t Capacity>
+	class CompletionQueue {
+		static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+	  public:
+		CompletionQueue()                       = default;
+		~CompletionQueue()                      = default;
+		CompletionQueue(const CompletionQueue&) = delete;
+		CompletionQueue(CompletionQueue&&)      = delete;
+		CompletionQueue& operator=(const CompletionQueue&) = delete;
+		CompletionQueue& operator=(CompletionQueue&&) = delete;
+
+		[[nodiscard]] bool Push(const T& a_value);
+		[[nodiscard]] bool Pop(T& a_value);
+		[[nodiscard]] bool Empty() const;
+
+	  private:
+		inline static constexpr uint32_t c_mask{Capacity - 1};
+
+		// head and tail on their own cache lines, one is written by the producer, the other by the consumer.
+		alignas(64) std::atomic<uint32_t> m_head{0};
+		alignas(64) std::atomic<uint32_t> m_tail{0};
+		T m_data[Capacity];
+	};
+
+	template<typename T, uint32_t Capacity>
+	bool CompletionQueue<T, Capacity>::Push(const T& a_value) {
+		uint32_t head = m_head.load(std::memory_order_relaxed);
+		if(head - m_tail.load(std::memory_order_acquire) == Capacity) { return false; }
+		m_data[head & c_mask] = a_value;
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, uint32_t Capacity>
+	bool CompletionQueue<T, Capacity>::Pop(T& a_value) {
+		uint32_t tail = m_tail.load(std::memory_order_relaxed);
+		if(tail == m_head.load(std::memory_order_acquire)) { return false; }
+		a_value = m_data[tail & c_mask];
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, uint32_t Capacity>
+	bool CompletionQueue<T, Capacity>::Empty() const {
+		return m_tail.load(std::memory_order_relaxed) == m_head.load(std::memory_order_acquire);
+	}
+}    // namespace CR::Graphics
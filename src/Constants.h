@@ -4,4 +4,6 @@
 
 namespace CR::Graphics {
 	inline static constexpr int32_t c_maxTextures = 1024;
+	// Resources the cpu writes every frame are buffered this many times.
+	inline static constexpr uint32_t c_maxFramesInFlight = 2;
 }    // namespace CR::Graphics
@@ -2,6 +2,8 @@
 
 #include "Constants.h"
 #include "EngineInternal.h"
+#include "FrameCounters.h"
+#include "HostAllocator.h"
 
 using namespace CR;
 
@@ -20,12 +22,13 @@ void Graphics::DescriptorPoolInit() {
 	poolInfo.poolSizeCount = (uint32_t)std::size(poolSize);
 	poolInfo.pPoolSizes    = std::data(poolSize);
 	poolInfo.maxSets       = 1;
+	poolInfo.flags         = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
 
-	m_pool = GetDevice().createDescriptorPool(poolInfo);
+	m_pool = GetDevice().createDescriptorPool(poolInfo, HostAllocator::Get());
 }
 
 void Graphics::DescriptorPoolDestroy() {
-	GetDevice().destroyDescriptorPool(m_pool);
+	GetDevice().destroyDescriptorPool(m_pool, HostAllocator::Get());
 }
 
 vk::DescriptorSet Graphics::CreateDescriptorSet(const vk::DescriptorSetLayout& a_layout) {
@@ -70,4 +73,5 @@ void Graphics::UpdateDescriptorSet(const vk::DescriptorSet& a_set, const vk::Sam
 	}
 
 	device.updateDescriptorSets((uint32_t)writeSets.size(), writeSets.data(), 0, nullptr);
+	FrameCounters::AddDescriptorWrites((uint32_t)writeSets.size());
 }
@@ -1,22 +1,37 @@
 ﻿#include "Graphics/Engine.h"
 
+#include "ApiRecorder.h"
 #include "AssetLoadingThread.h"
 #include "CommandPool.h"
 #include "Commands.h"
+#include "Constants.h"
 #include "DescriptorPool.h"
 #include "EngineInternal.h"
+#include "FrameCounters.h"
+#include "GpuProfiler.h"
+#include "HostAllocator.h"
+#include "MemoryAllocator.h"
+#include "NullDevice.h"
+#include "PipelineCache.h"
+#include "PipelineCompileThread.h"
+#include "RecordingThreads.h"
 #include "SpriteManagerBasic.h"
 #include "TextureSets.h"
+#include "Trace.h"
 
 #include "core/Log.h"
 #include "core/algorithm.h"
 
 #include "vulkan/vulkan.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <vector>
 
 using namespace CR;
@@ -26,6 +41,8 @@ using namespace std;
 using namespace std::string_literals;
 using namespace glm;
 
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
 namespace {
 	constexpr uint32_t MajorVersion = 0;    // 64K max
 	constexpr uint32_t MinorVersion = 1;    // 256 max
@@ -40,10 +57,18 @@ namespace {
 		Engine& operator=(const Engine&) = delete;
 		Engine& operator=(Engine&&) = delete;
 
-		void ExecutePending();
+		// Runs everything queued before frame a_framesCompleted.
+		void ExecutePending(uint64_t a_framesCompleted);
+		void ExecutePendingSkipped();
+		void CreateSwapchain(const vk::SwapchainKHR& a_oldSwapChain);
+		void DestroySwapchainResources();
+		bool RecreateSwapchain();
 
 		// private: internal so private anyway
+		// empty with the null backend
+		std::optional<vk::DynamicLoader> m_loader;
 		vk::Instance m_Instance;
+		vk::PhysicalDevice m_physicalDevice;
 		vk::Device m_Device;
 		int32_t m_GraphicsQueueIndex{-1};
 		int32_t m_TransferQueueIndex{-1};
@@ -57,42 +82,87 @@ namespace {
 		std::vector<vk::Image> m_PrimarySwapChainImages;
 		std::vector<vk::ImageView> m_primarySwapChainImageViews;
 		std::vector<vk::Framebuffer> m_frameBuffers;
+		bool m_swapChainDirty{false};         // window resized, or surface no longer matches the swap chain
 		vk::RenderPass m_RenderPass;          // only 1 currently, and only 1 subpass to go with it
-		vk::Semaphore m_renderingFinished;    // need to block presenting until all rendering has completed
 		vk::Fence m_frameFence;
-
-		uint32_t DeviceMemoryIndex{numeric_limits<uint32_t>::max()};
-		uint32_t HostMemoryIndex{numeric_limits<uint32_t>::max()};
+		vk::Fence m_submitFences[c_maxFramesInFlight];    // signaled when the gpu is done with that frame index
+		// need to block presenting until all rendering has completed. One per swap chain image, the presentation engine
+		// can still be waiting on an image's semaphore after its frame index comes around again.
+		std::vector<vk::Semaphore> m_renderingFinished;
+		vk::PresentModeKHR m_presentMode{vk::PresentModeKHR::eFifo};
+		uint32_t m_swapChainImages{2};
 
 		ivec2 m_WindowSize{0, 0};
 		std::optional<glm::vec4> m_clearColor;
 		uint32_t m_FrameRateDivisor{1};
+		vk::SampleCountFlagBits m_sampleCount{vk::SampleCountFlagBits::e4};
+		bool m_sampleShading{true};
+		bool m_reuseDrawCommands{true};
+		bool m_skipUnchangedFrames{false};
+		std::chrono::nanoseconds m_minFrameTime{0};    // from FrameLimit, 0 if not limited
+		std::chrono::nanoseconds m_refreshTime{0};     // stands in for vsync on skipped frames
+		std::chrono::steady_clock::time_point m_lastFrameStart;
 
-		CommandPool m_commandPool;
+		// One per frame in flight, reset as a whole once the gpu is done with that frame.
+		CommandPool m_commandPools[c_maxFramesInFlight];
 
 		std::unique_ptr<SpriteManagerBasic> m_spriteManagerBasic;
 
 		// Per frame members
 		uint32_t m_currentFrameBuffer{0};
-		CommandBuffer m_commandBuffer;
+		uint64_t m_frameNumber{0};
+		uint64_t m_framesCompleted{0};
+		CommandBuffer m_commandBuffers[c_maxFramesInFlight];
+
+		// Run once the gpu has finished the frame they were queued during.
+		struct PendingFunc {
+			uint64_t FrameNumber;
+			std::function<void()> Func;
+		};
+		std::vector<PendingFunc> m_nextFrameFuncs;
 
-		std::vector<std::function<void()>> m_nextFrameFuncs;
+		FrameStats m_frameStats[c_frameStatsHistory];
+		uint64_t m_frameStatsCount{0};
 
 		// MSAA
 		vk::Image m_msaaImage;
 		vk::ImageView m_msaaView;
-		vk::DeviceMemory m_msaaMemory;
+		Allocation m_msaaMemory;
 	};
 
+	// ms since a_last, and moves a_last up to now.
+	float Lap(chrono::steady_clock::time_point& a_last) {
+		auto now     = chrono::steady_clock::now();
+		float result = chrono::duration<float, milli>(now - a_last).count();
+		a_last       = now;
+		return result;
+	}
+
 	unique_ptr<Engine>& GetEngine() {
 		static unique_ptr<Engine> engine;
 		return engine;
 	}
 }    // namespace
 
-Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.ClearColor) {
+Engine::Engine(const EngineSettings& a_settings) :
+    m_clearColor(a_settings.ClearColor), m_sampleShading(a_settings.SampleShading),
+    m_reuseDrawCommands(a_settings.ReuseDrawCommands), m_skipUnchangedFrames(a_settings.SkipUnchangedFrames) {
 	// TODO: Should do some kind of pull down.
 	m_FrameRateDivisor = (a_settings.RefreshRate + 30) / 60;
+	if(a_settings.FrameLimit > 0) { m_minFrameTime = chrono::nanoseconds(1'000'000'000 / a_settings.FrameLimit); }
+	m_refreshTime = chrono::nanoseconds(1'000'000'000 / std::max(a_settings.RefreshRate, 1u));
+
+	HostAllocator::Init(a_settings.PoolHostAllocations);
+
+	// Every vulkan call goes through the default dispatcher, so switching backends is just a matter of where it gets
+	// its functions from.
+	if(a_settings.NullBackend) {
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(NullDevice::GetInstanceProcAddr());
+	} else {
+		m_loader.emplace();
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(
+		    m_loader->getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr"));
+	}
 
 	vector<string> enabledLayers;
 	if(a_settings.EnableDebug) {
@@ -120,16 +190,19 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 	createInfo.enabledExtensionCount   = a_settings.ExtensionsToEnableCount;
 	createInfo.ppEnabledExtensionNames = a_settings.ExtensionsToEnable;
 
-	m_Instance = vk::createInstance(createInfo);
+	m_Instance = vk::createInstance(createInfo, HostAllocator::Get());
+	VULKAN_HPP_DEFAULT_DISPATCHER.init(m_Instance);
 
-	Log::Assert(a_settings.HInstance != nullptr, "Hinstance is required, headless mode not currently supported");
-	Log::Assert(a_settings.Hwnd != nullptr, "Hwnd is required, headless mode not currently supported");
+	if(!a_settings.NullBackend) {
+		Log::Assert(a_settings.HInstance != nullptr, "Hinstance is required, headless mode not currently supported");
+		Log::Assert(a_settings.Hwnd != nullptr, "Hwnd is required, headless mode not currently supported");
+	}
 
 	vk::Win32SurfaceCreateInfoKHR win32Surface;
 	win32Surface.hinstance = reinterpret_cast<HINSTANCE>(a_settings.HInstance);
 	win32Surface.hwnd      = reinterpret_cast<HWND>(a_settings.Hwnd);
 
-	m_PrimarySurface = m_Instance.createWin32SurfaceKHR(win32Surface);
+	m_PrimarySurface = m_Instance.createWin32SurfaceKHR(win32Surface, HostAllocator::Get());
 
 	vector<vk::PhysicalDevice> physicalDevices = m_Instance.enumeratePhysicalDevices();
 
@@ -257,29 +330,16 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 			Log::Info("Host Heap. Size {}MB", heapSize);
 		}
 	}
+	// Memory types are picked per resource by the MemoryAllocator, just log what is available.
 	for(uint32_t i = 0; i < memProps.memoryTypeCount; ++i) {
-		auto& heapIndex    = memProps.memoryTypes[i].heapIndex;
-		auto& heapFlags    = memProps.memoryTypes[i].propertyFlags;
-		auto printHeapInfo = [&]() {
-			Log::Info("Device Heap:  {} Type Index: {}", heapIndex, i);
-			if(heapFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) { Log::Info("  Device local"); }
-			if(heapFlags & vk::MemoryPropertyFlagBits::eHostVisible) { Log::Info("  Host visible"); }
-			if(heapFlags & vk::MemoryPropertyFlagBits::eHostCached) { Log::Info("  Host cached"); }
-			if(heapFlags & vk::MemoryPropertyFlagBits::eHostCoherent) { Log::Info("  Host coherent"); }
-		};
-
-		if((heapFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) &&
-		   (DeviceMemoryIndex == numeric_limits<uint32_t>::max())) {
-			DeviceMemoryIndex = i;
-			printHeapInfo();
-		}
-
-		if(((heapFlags & vk::MemoryPropertyFlagBits::eHostVisible) &&
-		    (heapFlags & vk::MemoryPropertyFlagBits::eHostCoherent)) &&
-		   (HostMemoryIndex == numeric_limits<uint32_t>::max())) {
-			HostMemoryIndex = i;
-			printHeapInfo();
-		}
+		auto& heapIndex = memProps.memoryTypes[i].heapIndex;
+		auto& heapFlags = memProps.memoryTypes[i].propertyFlags;
+		Log::Info("Device Heap:  {} Type Index: {}", heapIndex, i);
+		if(heapFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) { Log::Info("  Device local"); }
+		if(heapFlags & vk::MemoryPropertyFlagBits::eHostVisible) { Log::Info("  Host visible"); }
+		if(heapFlags & vk::MemoryPropertyFlagBits::eHostCached) { Log::Info("  Host cached"); }
+		if(heapFlags & vk::MemoryPropertyFlagBits::eHostCoherent) { Log::Info("  Host coherent"); }
+		if(heapFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated) { Log::Info("  Lazily allocated"); }
 	}
 
 	vk::PhysicalDeviceFeatures2 requiredFeatures;
@@ -297,6 +357,7 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 	requiredFeatures12.shaderInputAttachmentArrayDynamicIndexing    = true;
 	requiredFeatures12.runtimeDescriptorArray                       = true;
 	requiredFeatures12.descriptorBindingSampledImageUpdateAfterBind = true;
+	requiredFeatures12.descriptorBindingUpdateUnusedWhilePending    = true;
 	requiredFeatures.pNext                                          = &requiredFeatures12;
 
 	int32_t graphicsQueueIndex     = 0;
@@ -332,18 +393,25 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 	vk::DeviceCreateInfo createLogDevInfo;
 	createLogDevInfo.queueCreateInfoCount    = (int)size(queueInfos);
 	createLogDevInfo.pQueueCreateInfos       = data(queueInfos);
-	createLogDevInfo.pEnabledFeatures        = &requiredFeatures.features;
+	// features are passed through the pNext chain, so the vulkan 1.2 features actually get enabled.
+	createLogDevInfo.pNext                   = &requiredFeatures;
+	createLogDevInfo.pEnabledFeatures        = nullptr;
 	createLogDevInfo.enabledLayerCount       = (uint32_t)enabledDeviceLayersPtrs.size();
 	createLogDevInfo.ppEnabledLayerNames     = enabledDeviceLayersPtrs.data();
 	createLogDevInfo.enabledExtensionCount   = (uint32_t)size(deviceExtensions);
 	createLogDevInfo.ppEnabledExtensionNames = data(deviceExtensions);
 
-	auto device = selectedDevice.createDevice(createLogDevInfo);
+	auto device = selectedDevice.createDevice(createLogDevInfo, HostAllocator::Get());
+	VULKAN_HPP_DEFAULT_DISPATCHER.init(device);
 
 	m_GraphicsQueue     = device.getQueue(m_GraphicsQueueIndex, graphicsQueueIndex);
 	m_PresentationQueue = device.getQueue(m_PresentationQueueIndex, presentationQueueIndex);
 	m_TransferQueue     = device.getQueue(m_TransferQueueIndex, transferQueueIndex);
 
+	MemoryAllocator::Init(selectedDevice, device);
+	PipelineCache::Init(selectedDevice, device, a_settings.PipelineCachePath);
+	GpuProfiler::Init(selectedDevice, device, (uint32_t)m_GraphicsQueueIndex);
+
 	auto surfaceCaps = selectedDevice.getSurfaceCapabilitiesKHR(m_PrimarySurface);
 	Log::Info("current surface resolution: {}x{}", surfaceCaps.maxImageExtent.width, surfaceCaps.maxImageExtent.height);
 	Log::Info("Min image count: {} Max image count: {}", surfaceCaps.minImageCount, surfaceCaps.maxImageCount);
@@ -359,32 +427,143 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 	for(const auto& mode : presentModes) { Log::Info("    Presentation Mode: {}", to_string(mode)); }
 
 	{
+		vk::PresentModeKHR wanted = vk::PresentModeKHR::eFifo;
+		switch(a_settings.PresentationMode) {
+			case PresentMode::Fifo: wanted = vk::PresentModeKHR::eFifo; break;
+			case PresentMode::FifoRelaxed: wanted = vk::PresentModeKHR::eFifoRelaxed; break;
+			case PresentMode::Mailbox: wanted = vk::PresentModeKHR::eMailbox; break;
+			case PresentMode::Immediate: wanted = vk::PresentModeKHR::eImmediate; break;
+		}
+		// fifo is the only mode the spec guarantees.
+		if(find(begin(presentModes), end(presentModes), wanted) != end(presentModes)) {
+			m_presentMode = wanted;
+		} else {
+			Log::Info("Presentation mode {} not supported, using fifo instead", to_string(wanted));
+		}
+		m_swapChainImages = a_settings.SwapChainImages;
+	}
+
+	{
+		Log::Require(a_settings.MsaaSamples == 1 || a_settings.MsaaSamples == 2 || a_settings.MsaaSamples == 4 ||
+		                 a_settings.MsaaSamples == 8,
+		             "MsaaSamples must be 1, 2, 4, or 8");
+		auto supportedCounts = selectedDevice.getProperties().limits.framebufferColorSampleCounts;
+		uint32_t samples     = a_settings.MsaaSamples;
+		while(samples > 1 && !(supportedCounts & (vk::SampleCountFlagBits)samples)) { samples /= 2; }
+		if(samples != a_settings.MsaaSamples) {
+			Log::Info("{}x MSAA not supported, using {}x instead", a_settings.MsaaSamples, samples);
+		}
+		m_sampleCount = (vk::SampleCountFlagBits)samples;
+	}
+
+	// Attachment 0 is the msaa image, or the swap chain image without msaa. Attachment 1 is the resolve target.
+	bool useMsaa                = m_sampleCount != vk::SampleCountFlagBits::e1;
+	vk::ImageLayout finalLayout = useMsaa ? vk::ImageLayout::eColorAttachmentOptimal : vk::ImageLayout::ePresentSrcKHR;
+
+	vk::AttachmentDescription attatchDescs[2];
+	attatchDescs[0].initialLayout = vk::ImageLayout::eUndefined;
+	attatchDescs[0].finalLayout   = finalLayout;
+	attatchDescs[0].format        = vk::Format::eB8G8R8A8Srgb;
+	if(a_settings.ClearColor.has_value()) {
+		attatchDescs[0].loadOp = vk::AttachmentLoadOp::eClear;
+	} else {
+		attatchDescs[0].loadOp = vk::AttachmentLoadOp::eDontCare;
+	}
+	// msaa image is resolved in the render pass, nothing needs its contents after that.
+	attatchDescs[0].storeOp        = useMsaa ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
+	attatchDescs[0].samples        = m_sampleCount;
+	attatchDescs[0].stencilLoadOp  = vk::AttachmentLoadOp::eDontCare;
+	attatchDescs[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+	attatchDescs[1].initialLayout  = vk::ImageLayout::eUndefined;
+	attatchDescs[1].finalLayout    = vk::ImageLayout::ePresentSrcKHR;
+	attatchDescs[1].format         = vk::Format::eB8G8R8A8Srgb;
+	attatchDescs[1].loadOp         = vk::AttachmentLoadOp::eDontCare;
+	// TODO should be dont care for mobile
+	attatchDescs[1].storeOp        = vk::AttachmentStoreOp::eStore;
+	attatchDescs[1].samples        = vk::SampleCountFlagBits::e1;
+	attatchDescs[1].stencilLoadOp  = vk::AttachmentLoadOp::eDontCare;
+	attatchDescs[1].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+
+	vk::AttachmentReference attachRefs[2];
+	attachRefs[0].attachment = 0;
+	attachRefs[0].layout     = vk::ImageLayout::eColorAttachmentOptimal;
+	attachRefs[1].attachment = 1;
+	attachRefs[1].layout     = vk::ImageLayout::eColorAttachmentOptimal;
+
+	vk::SubpassDescription subpassDesc;
+	subpassDesc.pipelineBindPoint    = vk::PipelineBindPoint::eGraphics;
+	subpassDesc.colorAttachmentCount = 1;
+	subpassDesc.pColorAttachments    = &attachRefs[0];
+	subpassDesc.pResolveAttachments  = useMsaa ? &attachRefs[1] : nullptr;
+
+	vk::RenderPassCreateInfo renderPassInfo;
+	renderPassInfo.attachmentCount = useMsaa ? 2 : 1;
+	renderPassInfo.pAttachments    = attatchDescs;
+	renderPassInfo.subpassCount    = 1;
+	renderPassInfo.pSubpasses      = &subpassDesc;
+
+	m_RenderPass = device.createRenderPass(renderPassInfo, HostAllocator::Get());
+
+	vk::FenceCreateInfo fenceInfo;
+	m_frameFence = device.createFence(fenceInfo, HostAllocator::Get());
+
+	fenceInfo.flags = vk::FenceCreateFlagBits::eSignaled;
+	for(auto& fence : m_submitFences) { fence = device.createFence(fenceInfo, HostAllocator::Get()); }
+
+	m_Device         = device;
+	m_physicalDevice = selectedDevice;
+	CreateSwapchain(vk::SwapchainKHR{});
+}
+
+Engine::~Engine() {
+	m_Device.destroyFence(m_frameFence, HostAllocator::Get());
+	for(auto& fence : m_submitFences) { m_Device.destroyFence(fence, HostAllocator::Get()); }
+	DestroySwapchainResources();
+	m_Device.destroySwapchainKHR(m_PrimarySwapChain, HostAllocator::Get());
+	m_Device.destroyRenderPass(m_RenderPass, HostAllocator::Get());
+	GpuProfiler::Shutdown();
+	PipelineCache::Shutdown();
+	MemoryAllocator::Shutdown();
+	m_Device.destroy(HostAllocator::Get());
+
+	m_Instance.destroySurfaceKHR(m_PrimarySurface, HostAllocator::Get());
+	m_Instance.destroy(HostAllocator::Get());
+	HostAllocator::Shutdown();
+}
+
+void Engine::CreateSwapchain(const vk::SwapchainKHR& a_oldSwapChain) {
+	auto surfaceCaps    = m_physicalDevice.getSurfaceCapabilitiesKHR(m_PrimarySurface);
+	vk::Extent2D extent = surfaceCaps.currentExtent;
+	// max uint means the swap chain decides the surface size, no better answer than the biggest it can be.
+	if(extent.width == numeric_limits<uint32_t>::max()) { extent = surfaceCaps.maxImageExtent; }
+	m_WindowSize = ivec2(extent.width, extent.height);
+	// minimized, nothing to render to until the window comes back.
+	if(extent.width == 0 || extent.height == 0) { return; }
+
+	bool useMsaa = m_sampleCount != vk::SampleCountFlagBits::e1;
+
+	// Without MSAA we render straight into the swap chain, no msaa image or resolve needed.
+	if(useMsaa) {
 		// msaa image
 		vk::ImageCreateInfo msaaCreateInfo;
-		msaaCreateInfo.extent.width  = surfaceCaps.maxImageExtent.width;
-		msaaCreateInfo.extent.height = surfaceCaps.maxImageExtent.height;
+		msaaCreateInfo.extent.width  = extent.width;
+		msaaCreateInfo.extent.height = extent.height;
 		msaaCreateInfo.extent.depth  = 1;
 		msaaCreateInfo.arrayLayers   = 1;
 		msaaCreateInfo.mipLevels     = 1;
-		msaaCreateInfo.samples       = vk::SampleCountFlagBits::e4;
+		msaaCreateInfo.samples       = m_sampleCount;
 		msaaCreateInfo.tiling        = vk::ImageTiling::eOptimal;
 		msaaCreateInfo.sharingMode   = vk::SharingMode::eExclusive;
-		// TODO should be a transient attachment on mobile
-		msaaCreateInfo.usage         = vk::ImageUsageFlagBits::eColorAttachment;
 		msaaCreateInfo.initialLayout = vk::ImageLayout::eUndefined;
 		msaaCreateInfo.imageType     = vk::ImageType::e2D;
 		msaaCreateInfo.flags         = vk::ImageCreateFlags{0};
 		msaaCreateInfo.format        = vk::Format::eB8G8R8A8Srgb;
 
-		m_msaaImage = device.createImage(msaaCreateInfo);
+		// Only ever lives for one render pass and gets resolved, so on tilers it never has to leave tile memory.
+		msaaCreateInfo.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransientAttachment;
 
-		auto imageRequirements = device.getImageMemoryRequirements(m_msaaImage);
-		vk::MemoryAllocateInfo allocInfo;
-		allocInfo.memoryTypeIndex = DeviceMemoryIndex;
-		allocInfo.allocationSize  = imageRequirements.size;
-		m_msaaMemory              = device.allocateMemory(allocInfo);
-
-		device.bindImageMemory(m_msaaImage, m_msaaMemory, 0);
+		m_msaaImage  = m_Device.createImage(msaaCreateInfo, HostAllocator::Get());
+		m_msaaMemory = MemoryAllocator::Allocate(m_msaaImage, MemoryUsage::Transient);
 
 		vk::ImageViewCreateInfo viewInfo;
 		viewInfo.image                           = m_msaaImage;
@@ -396,14 +575,14 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount     = 1;
 
-		m_msaaView = device.createImageView(viewInfo);
+		m_msaaView = m_Device.createImageView(viewInfo, HostAllocator::Get());
 	}
 
 	vk::SwapchainCreateInfoKHR swapCreateInfo;
 	swapCreateInfo.setClipped(true);
 	swapCreateInfo.setCompositeAlpha(vk::CompositeAlphaFlagBitsKHR::eOpaque);
 	swapCreateInfo.setImageColorSpace(vk::ColorSpaceKHR::eSrgbNonlinear);
-	swapCreateInfo.setImageExtent(surfaceCaps.maxImageExtent);
+	swapCreateInfo.setImageExtent(extent);
 	swapCreateInfo.setImageFormat(vk::Format::eB8G8R8A8Srgb);
 	if(m_GraphicsQueueIndex == m_PresentationQueueIndex) {
 		swapCreateInfo.setImageSharingMode(vk::SharingMode::eExclusive);
@@ -417,14 +596,18 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 		swapCreateInfo.setPQueueFamilyIndices(data(queueFamilyIndices));
 	}
 	swapCreateInfo.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment);
-	swapCreateInfo.setMinImageCount(2);
-	swapCreateInfo.setPresentMode(vk::PresentModeKHR::eFifo);
+	// maxImageCount of 0 means no limit.
+	uint32_t imageCount = std::max(m_swapChainImages, surfaceCaps.minImageCount);
+	if(surfaceCaps.maxImageCount > 0) { imageCount = std::min(imageCount, surfaceCaps.maxImageCount); }
+	swapCreateInfo.setMinImageCount(imageCount);
+	swapCreateInfo.setPresentMode(m_presentMode);
 	swapCreateInfo.setPreTransform(vk::SurfaceTransformFlagBitsKHR::eIdentity);
 	swapCreateInfo.setSurface(m_PrimarySurface);
 	swapCreateInfo.setImageArrayLayers(1);
+	swapCreateInfo.setOldSwapchain(a_oldSwapChain);
 
-	m_PrimarySwapChain       = device.createSwapchainKHR(swapCreateInfo);
-	m_PrimarySwapChainImages = device.getSwapchainImagesKHR(m_PrimarySwapChain);
+	m_PrimarySwapChain       = m_Device.createSwapchainKHR(swapCreateInfo, HostAllocator::Get());
+	m_PrimarySwapChainImages = m_Device.getSwapchainImagesKHR(m_PrimarySwapChain);
 	for(const auto& image : m_PrimarySwapChainImages) {
 		vk::ImageViewCreateInfo viewInfo;
 		viewInfo.setFormat(vk::Format::eB8G8R8A8Srgb);
@@ -435,166 +618,274 @@ Engine::Engine(const EngineSettings& a_settings) : m_clearColor(a_settings.Clear
 		viewInfo.subresourceRange.layerCount     = 1;
 		viewInfo.subresourceRange.baseMipLevel   = 0;
 		viewInfo.subresourceRange.levelCount     = 1;
-		m_primarySwapChainImageViews.push_back(device.createImageView(viewInfo));
+		m_primarySwapChainImageViews.push_back(m_Device.createImageView(viewInfo, HostAllocator::Get()));
+		m_renderingFinished.push_back(m_Device.createSemaphore(vk::SemaphoreCreateInfo{}, HostAllocator::Get()));
 	}
-	m_WindowSize = ivec2(surfaceCaps.maxImageExtent.width, surfaceCaps.maxImageExtent.height);
 
-	vk::AttachmentDescription attatchDescs[2];
-	attatchDescs[0].initialLayout = vk::ImageLayout::eUndefined;
-	attatchDescs[0].finalLayout   = vk::ImageLayout::eColorAttachmentOptimal;
-	attatchDescs[0].format        = vk::Format::eB8G8R8A8Srgb;
-	if(a_settings.ClearColor.has_value()) {
-		attatchDescs[0].loadOp = vk::AttachmentLoadOp::eClear;
-	} else {
-		attatchDescs[0].loadOp = vk::AttachmentLoadOp::eDontCare;
-	}
-	// TODO should be dont care for mobile, would be transient and never need to be stored to memory
-	attatchDescs[0].storeOp        = vk::AttachmentStoreOp::eStore;
-	attatchDescs[0].samples        = vk::SampleCountFlagBits::e4;
-	attatchDescs[0].stencilLoadOp  = vk::AttachmentLoadOp::eDontCare;
-	attatchDescs[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-	attatchDescs[1].initialLayout  = vk::ImageLayout::eUndefined;
-	attatchDescs[1].finalLayout    = vk::ImageLayout::ePresentSrcKHR;
-	attatchDescs[1].format         = vk::Format::eB8G8R8A8Srgb;
-	attatchDescs[1].loadOp         = vk::AttachmentLoadOp::eDontCare;
-	// TODO should be dont care for mobile
-	attatchDescs[1].storeOp        = vk::AttachmentStoreOp::eStore;
-	attatchDescs[1].samples        = vk::SampleCountFlagBits::e1;
-	attatchDescs[1].stencilLoadOp  = vk::AttachmentLoadOp::eDontCare;
-	attatchDescs[1].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-
-	vk::AttachmentReference attachRefs[2];
-	attachRefs[0].attachment = 0;
-	attachRefs[0].layout     = vk::ImageLayout::eColorAttachmentOptimal;
-	attachRefs[1].attachment = 1;
-	attachRefs[1].layout     = vk::ImageLayout::eColorAttachmentOptimal;
-
-	vk::SubpassDescription subpassDesc;
-	subpassDesc.pipelineBindPoint    = vk::PipelineBindPoint::eGraphics;
-	subpassDesc.colorAttachmentCount = 1;
-	subpassDesc.pColorAttachments    = &attachRefs[0];
-	subpassDesc.pResolveAttachments  = &attachRefs[1];
-
-	vk::RenderPassCreateInfo renderPassInfo;
-	renderPassInfo.attachmentCount = 2;
-	renderPassInfo.pAttachments    = attatchDescs;
-	renderPassInfo.subpassCount    = 1;
-	renderPassInfo.pSubpasses      = &subpassDesc;
-
-	m_RenderPass = device.createRenderPass(renderPassInfo);
 
 	for(auto& imageView : m_primarySwapChainImageViews) {
 		vk::FramebufferCreateInfo framebufferInfo;
-		const vk::ImageView attachments[] = {m_msaaView, imageView};
-		framebufferInfo.attachmentCount   = 2;
-		framebufferInfo.pAttachments      = attachments;
-		framebufferInfo.width             = m_WindowSize.x;
-		framebufferInfo.height            = m_WindowSize.y;
-		framebufferInfo.renderPass        = m_RenderPass;
-		framebufferInfo.layers            = 1;
-
-		m_frameBuffers.push_back(device.createFramebuffer(framebufferInfo));
+		const vk::ImageView msaaAttachments[] = {m_msaaView, imageView};
+		framebufferInfo.attachmentCount       = useMsaa ? 2 : 1;
+		framebufferInfo.pAttachments          = useMsaa ? msaaAttachments : &imageView;
+		framebufferInfo.width                 = extent.width;
+		framebufferInfo.height                = extent.height;
+		framebufferInfo.renderPass            = m_RenderPass;
+		framebufferInfo.layers                = 1;
+
+		m_frameBuffers.push_back(m_Device.createFramebuffer(framebufferInfo, HostAllocator::Get()));
 	}
-
-	vk::SemaphoreCreateInfo semInfo;
-	m_renderingFinished = device.createSemaphore(semInfo);
-
-	vk::FenceCreateInfo fenceInfo;
-	m_frameFence = device.createFence(fenceInfo);
-
-	m_Device = device;
 }
 
-Engine::~Engine() {
-	m_Device.destroyFence(m_frameFence);
-	m_Device.destroySemaphore(m_renderingFinished);
-	for(auto& framebuffer : m_frameBuffers) { m_Device.destroyFramebuffer(framebuffer); }
-	m_Device.destroyRenderPass(m_RenderPass);
-	m_Device.destroyImageView(m_msaaView);
-	m_Device.destroyImage(m_msaaImage);
-	m_Device.freeMemory(m_msaaMemory);
-	for(auto& imageView : m_primarySwapChainImageViews) { m_Device.destroyImageView(imageView); }
+void Engine::DestroySwapchainResources() {
+	for(auto& framebuffer : m_frameBuffers) { m_Device.destroyFramebuffer(framebuffer, HostAllocator::Get()); }
+	m_frameBuffers.clear();
+	for(auto& imageView : m_primarySwapChainImageViews) { m_Device.destroyImageView(imageView, HostAllocator::Get()); }
 	m_primarySwapChainImageViews.clear();
-	m_Device.destroySwapchainKHR(m_PrimarySwapChain);
-	m_Device.destroy();
+	for(auto& semaphore : m_renderingFinished) { m_Device.destroySemaphore(semaphore, HostAllocator::Get()); }
+	m_renderingFinished.clear();
+	m_PrimarySwapChainImages.clear();
+	m_Device.destroyImageView(m_msaaView, HostAllocator::Get());
+	m_Device.destroyImage(m_msaaImage, HostAllocator::Get());
+	MemoryAllocator::Free(m_msaaMemory);
+	m_msaaView  = vk::ImageView{};
+	m_msaaImage = vk::Image{};
+}
 
-	m_Instance.destroySurfaceKHR(m_PrimarySurface);
-	m_Instance.destroy();
+// Only the swap chain and what depends on its size is rebuilt. The render pass doesn't change, so pipelines stay
+// compatible and don't need recompiling. Returns false while minimized, nothing to render to until the window comes
+// back. The gpu is left alone until then.
+bool Engine::RecreateSwapchain() {
+	CR_TRACE_SCOPE("RecreateSwapchain");
+	vk::Extent2D extent = m_physicalDevice.getSurfaceCapabilitiesKHR(m_PrimarySurface).currentExtent;
+	if(extent.width == 0 || extent.height == 0) { return false; }
+
+	m_Device.waitIdle();
+	DestroySwapchainResources();
+	vk::SwapchainKHR oldSwapChain = m_PrimarySwapChain;
+	m_PrimarySwapChain            = vk::SwapchainKHR{};
+	CreateSwapchain(oldSwapChain);
+	m_Device.destroySwapchainKHR(oldSwapChain, HostAllocator::Get());
+	m_swapChainDirty = false;
+	// could have been minimized in between
+	return (bool)m_PrimarySwapChain;
 }
 
-void Engine::ExecutePending() {
-	for(auto& func : m_nextFrameFuncs) { func(); }
-	m_nextFrameFuncs.clear();
+void Engine::ExecutePending(uint64_t a_framesCompleted) {
+	CR_TRACE_SCOPE("ExecutePending");
+	auto done = stable_partition(
+	    begin(m_nextFrameFuncs), end(m_nextFrameFuncs),
+	    [a_framesCompleted](const PendingFunc& a_func) { return a_func.FrameNumber < a_framesCompleted; });
+	for(auto iter = begin(m_nextFrameFuncs); iter != done; ++iter) { iter->Func(); }
+	m_nextFrameFuncs.erase(begin(m_nextFrameFuncs), done);
+}
+
+// Skipped frames never wait on the gpu, so check what it finished without blocking. Otherwise a static screen would
+// hold on to everything freed since the last real frame. Once all submitted frames are done, nothing is in flight, and
+// even what was queued since the last real frame can run.
+void Engine::ExecutePendingSkipped() {
+	for(uint64_t frame = m_frameNumber; frame > m_framesCompleted; --frame) {
+		if(m_Device.getFenceStatus(m_submitFences[(frame - 1) % c_maxFramesInFlight]) == vk::Result::eSuccess) {
+			m_framesCompleted = frame;
+			break;
+		}
+	}
+	ExecutePending(m_framesCompleted == m_frameNumber ? m_frameNumber + 1 : m_framesCompleted);
 }
 
 void Graphics::CreateEngine(const EngineSettings& a_settings) {
 	assert(!GetEngine().get());
 	GetEngine()                = make_unique<Engine>(a_settings);
-	GetEngine()->m_commandPool = CommandPool(CommandPool::PoolType::Primary);
+	for(auto& pool : GetEngine()->m_commandPools) { pool = CommandPool(CommandPool::PoolType::Primary); }
 	DescriptorPoolInit();
 	AssetLoadingThread::Init();
+	PipelineCompileThread::Init();
+	RecordingThreads::Init();
 	TextureSets::Init();
 	GetEngine()->m_spriteManagerBasic = make_unique<SpriteManagerBasic>();
+	if(!a_settings.RecordPath.empty()) { ApiRecorder::Start(a_settings.RecordPath, a_settings); }
 }
 
-void Graphics::Frame() {
+bool Graphics::Frame() {
 	assert(GetEngine().get());
 	auto* engine = GetEngine().get();
+	CR_TRACE_SCOPE("Frame");
+	ApiRecorder::Frame();
+
+	if(engine->m_minFrameTime.count() > 0) {
+		CR_TRACE_SCOPE("FrameLimit");
+		this_thread::sleep_until(engine->m_lastFrameStart + engine->m_minFrameTime);
+	}
+	engine->m_lastFrameStart = chrono::steady_clock::now();
+	// Nothing to present, so no vsync to keep us from spinning.
+	auto skipFrame = [engine]() {
+		CR_TRACE_SCOPE("SkipFrame");
+		engine->ExecutePendingSkipped();
+		this_thread::sleep_until(engine->m_lastFrameStart + engine->m_refreshTime);
+		return false;
+	};
 
-	engine->ExecutePending();
+	// Animations are timed in calls to Frame, so this has to run even if the frame is skipped.
+	bool changed = false;
+	{
+		CR_TRACE_SCOPE("Update");
+		changed |= engine->m_spriteManagerBasic->Update();
+		changed |= TextureSets::HasCompletedTasks();
+	}
+	changed |= engine->m_swapChainDirty || engine->m_frameNumber == 0;
+	if(engine->m_skipUnchangedFrames && !changed) { return skipFrame(); }
 
-	engine->m_currentFrameBuffer =
-	    engine->m_Device
-	        .acquireNextImageKHR(engine->m_PrimarySwapChain, UINT64_MAX, vk::Semaphore{}, engine->m_frameFence)
-	        .value;
+	if(engine->m_swapChainDirty || !engine->m_PrimarySwapChain) {
+		if(!engine->RecreateSwapchain()) { return skipFrame(); }
+	}
 
-	engine->m_Device.waitForFences(1, &engine->m_frameFence, true, UINT64_MAX);
-	engine->m_Device.resetFences(1, &engine->m_frameFence);
+	FrameStats stats;
+	auto lapStart = chrono::steady_clock::now();
+
+	try {
+		CR_TRACE_SCOPE("Acquire");
+		auto acquired = engine->m_Device.acquireNextImageKHR(engine->m_PrimarySwapChain, UINT64_MAX, vk::Semaphore{},
+		                                                     engine->m_frameFence);
+		// suboptimal still gives us an image we can present, rebuild next frame.
+		if(acquired.result == vk::Result::eSuboptimalKHR) { engine->m_swapChainDirty = true; }
+		engine->m_currentFrameBuffer = acquired.value;
+	} catch(const vk::OutOfDateKHRError&) {
+		engine->m_swapChainDirty = true;
+		return false;
+	}
 
-	engine->m_commandBuffer = engine->m_commandPool.CreateCommandBuffer();
+	vk::Fence& submitFence = engine->m_submitFences[GetFrameIndex()];
+	{
+		CR_TRACE_SCOPE("GpuWait");
+		engine->m_Device.waitForFences(1, &engine->m_frameFence, true, UINT64_MAX);
+		engine->m_Device.resetFences(1, &engine->m_frameFence);
+
+		// Last user of this frame index must be done before we reuse anything buffered per frame. Queue executes in
+		// order, so every frame before it is done as well.
+		engine->m_Device.waitForFences(1, &submitFence, true, UINT64_MAX);
+		engine->m_Device.resetFences(1, &submitFence);
+	}
+	if(engine->m_frameNumber >= c_maxFramesInFlight) {
+		engine->m_framesCompleted =
+		    std::max(engine->m_framesCompleted, engine->m_frameNumber - c_maxFramesInFlight + 1);
+	}
+	stats.GpuWaitMs = Lap(lapStart);
+	engine->ExecutePending(engine->m_framesCompleted);
+	stats.ExecutePendingMs = Lap(lapStart);
+
+	// gpu is done with everything recorded for this frame index, reuse it all. No driver allocations once warmed up.
+	CommandBuffer& commandBuffer = engine->m_commandBuffers[GetFrameIndex()];
+	CommandPool& commandPool     = engine->m_commandPools[GetFrameIndex()];
+	commandBuffer                = CommandBuffer{};
+	commandPool.Reset();
+	commandBuffer = commandPool.CreateCommandBuffer();
+
+	commandBuffer.Begin();
+	GpuProfiler::BeginFrame(commandBuffer);
+
+	GpuProfiler::BeginPhase(commandBuffer, GpuProfiler::Phase::Upload);
+	lapStart = chrono::steady_clock::now();
+	{
+		CR_TRACE_SCOPE("CheckLoadingTasks");
+		engine->m_spriteManagerBasic->TexturesLoaded(TextureSets::CheckLoadingTasks(commandBuffer));
+	}
+	stats.CheckLoadingTasksMs = Lap(lapStart);
+	{
+		CR_TRACE_SCOPE("SpriteFrame");
+		engine->m_spriteManagerBasic->Frame(commandBuffer);
+	}
+	stats.SpriteFrameMs = Lap(lapStart);
+	GpuProfiler::EndPhase(commandBuffer, GpuProfiler::Phase::Upload);
 
-	engine->m_commandBuffer.Begin();
+	lapStart = chrono::steady_clock::now();
+	{
+		CR_TRACE_SCOPE("RecordDraws");
+		if(engine->m_reuseDrawCommands) {
+			engine->m_spriteManagerBasic->DrawCached();
+		} else {
+			engine->m_spriteManagerBasic->RecordDraws();
+		}
 
-	TextureSets::CheckLoadingTasks(engine->m_commandBuffer);
-	engine->m_spriteManagerBasic->Frame(engine->m_commandBuffer);
+		// The primary can't write timestamps inside a render pass that uses secondaries, so the split between drawing
+		// and the resolve at the end of the render pass is written from a secondary that runs after all the draws.
+		RecordingThreads::Record([](CommandBuffer& a_cmdBuffer) {
+			GpuProfiler::EndPhase(a_cmdBuffer, GpuProfiler::Phase::Draw);
+			GpuProfiler::BeginPhase(a_cmdBuffer, GpuProfiler::Phase::Resolve);
+		});
+
+		GpuProfiler::BeginPhase(commandBuffer, GpuProfiler::Phase::Draw);
+		engine->m_spriteManagerBasic->AcquireVertexBuffer(commandBuffer);
+		Commands::RenderPassBegin(commandBuffer, engine->m_clearColor, vk::SubpassContents::eSecondaryCommandBuffers);
+		RecordingThreads::Execute(commandBuffer);
+		stats.DrawMs = Lap(lapStart);
+	}
+	Commands::RenderPassEnd(commandBuffer);
+	GpuProfiler::EndPhase(commandBuffer, GpuProfiler::Phase::Resolve);
+	commandBuffer.End();
 
-	Commands::RenderPassBegin(engine->m_commandBuffer, engine->m_clearColor);
-	engine->m_spriteManagerBasic->Draw(engine->m_commandBuffer);
-	Commands::RenderPassEnd(engine->m_commandBuffer);
-	engine->m_commandBuffer.End();
+	vk::Semaphore& renderingFinished = engine->m_renderingFinished[engine->m_currentFrameBuffer];
 
 	vk::SubmitInfo subInfo;
 	subInfo.commandBufferCount   = 1;
-	subInfo.pCommandBuffers      = &engine->m_commandBuffer.GetHandle();
+	subInfo.pCommandBuffers      = &commandBuffer.GetHandle();
 	subInfo.waitSemaphoreCount   = 0;
 	subInfo.signalSemaphoreCount = 1;
-	subInfo.pSignalSemaphores    = &engine->m_renderingFinished;
-	engine->m_GraphicsQueue.submit(subInfo, vk::Fence{});
+	subInfo.pSignalSemaphores    = &renderingFinished;
+	{
+		CR_TRACE_SCOPE("Submit");
+		engine->m_GraphicsQueue.submit(subInfo, submitFence);
+	}
 
 	vk::PresentInfoKHR presInfo;
 	presInfo.waitSemaphoreCount = 1;
-	presInfo.pWaitSemaphores    = &engine->m_renderingFinished;
+	presInfo.pWaitSemaphores    = &renderingFinished;
 	presInfo.swapchainCount     = 1;
 	presInfo.pSwapchains        = &engine->m_PrimarySwapChain;
 	presInfo.pImageIndices      = &engine->m_currentFrameBuffer;
-	engine->m_PresentationQueue.presentKHR(presInfo);
+	try {
+		CR_TRACE_SCOPE("Present");
+		if(engine->m_PresentationQueue.presentKHR(presInfo) == vk::Result::eSuboptimalKHR) {
+			engine->m_swapChainDirty = true;
+		}
+	} catch(const vk::OutOfDateKHRError&) { engine->m_swapChainDirty = true; }
+
+	auto counters                 = FrameCounters::TakeCounters();
+	stats.FrameNumber             = engine->m_frameNumber;
+	stats.SpritesDrawn            = engine->m_spriteManagerBasic->GetSpritesDrawn();
+	stats.BytesUploaded           = counters.BytesUploaded;
+	stats.DescriptorWrites        = counters.DescriptorWrites;
+	stats.CommandBuffersAllocated = counters.CommandBuffersAllocated;
+	stats.PendingAssetLoads       = counters.PendingAssetLoads;
+	stats.HostAllocations         = counters.HostAllocations;
+	engine->m_frameStats[engine->m_frameStatsCount++ % c_frameStatsHistory] = stats;
+
+	// No waiting on the gpu here, the submit fence wait above keeps it at most c_maxFramesInFlight behind.
+	++engine->m_frameNumber;
+	return true;
+}
 
-	// Don't allow gpu to get behind, sacrifice performance for minimal latency.
-	engine->m_GraphicsQueue.waitIdle();
-	engine->m_PresentationQueue.waitIdle();
+void Graphics::WindowResized() {
+	assert(GetEngine().get());
+	ApiRecorder::WindowResized();
+	GetEngine()->m_swapChainDirty = true;
 }
 
 void Graphics::ShutdownEngine() {
+	ApiRecorder::Stop();
 	AssetLoadingThread::Shutdown();
 	assert(GetEngine().get());
 	GetEngine()->m_Device.waitIdle();
-	GetEngine()->ExecutePending();
-	GetEngine()->m_commandBuffer = CommandBuffer{};
-	GetEngine()->m_commandPool   = CommandPool{};
+	// gpu is idle, and nothing else will be submitted. Everything pending can run now.
+	GetEngine()->m_framesCompleted = GetEngine()->m_frameNumber + 1;
+	GetEngine()->ExecutePending(GetEngine()->m_framesCompleted);
+	for(auto& commandBuffer : GetEngine()->m_commandBuffers) { commandBuffer = CommandBuffer{}; }
+	for(auto& pool : GetEngine()->m_commandPools) { pool = CommandPool{}; }
 	GetEngine()->m_spriteManagerBasic.reset();
+	RecordingThreads::Shutdown();
+	PipelineCompileThread::Shutdown();
 	TextureSets::Shutdown();
 	DescriptorPoolDestroy();
-	GetEngine()->ExecutePending();
+	GetEngine()->ExecutePending(GetEngine()->m_framesCompleted);
 	GetEngine()->m_Device.waitIdle();
 	GetEngine().reset();
 }
@@ -604,14 +895,15 @@ vk::Device& Graphics::GetDevice() {
 	return GetEngine()->m_Device;
 }
 
-uint32_t Graphics::GetDeviceMemoryIndex() {
+const FrameStats& Graphics::GetFrameStats(uint32_t a_framesAgo) {
 	assert(GetEngine().get());
-	return GetEngine()->DeviceMemoryIndex;
-}
+	auto* engine = GetEngine().get();
+	static const FrameStats empty;
+	if(engine->m_frameStatsCount == 0) { return empty; }
 
-uint32_t Graphics::GetHostMemoryIndex() {
-	assert(GetEngine().get());
-	return GetEngine()->HostMemoryIndex;
+	uint64_t available = std::min<uint64_t>(engine->m_frameStatsCount, c_frameStatsHistory);
+	uint64_t framesAgo = std::min<uint64_t>(a_framesAgo, available - 1);
+	return engine->m_frameStats[(engine->m_frameStatsCount - 1 - framesAgo) % c_frameStatsHistory];
 }
 
 uint32_t Graphics::GetGraphicsQueueIndex() {
@@ -651,10 +943,40 @@ SpriteManagerBasic& Graphics::GetSpriteManagerBasic() {
 
 void Graphics::ExecuteNextFrame(std::function<void()> a_func) {
 	assert(GetEngine().get());
-	GetEngine()->m_nextFrameFuncs.push_back(move(a_func));
+	GetEngine()->m_nextFrameFuncs.push_back({GetEngine()->m_frameNumber, move(a_func)});
+}
+
+void Graphics::SetSkipUnchangedFrames(bool a_skip) {
+	assert(GetEngine().get());
+	GetEngine()->m_skipUnchangedFrames = a_skip;
 }
 
 uint32_t Graphics::GetFrameRateDivisor() {
 	assert(GetEngine().get());
 	return GetEngine()->m_FrameRateDivisor;
 }
+
+vk::SampleCountFlagBits Graphics::GetSampleCount() {
+	assert(GetEngine().get());
+	return GetEngine()->m_sampleCount;
+}
+
+bool Graphics::GetSampleShading() {
+	assert(GetEngine().get());
+	return GetEngine()->m_sampleShading;
+}
+
+uint32_t Graphics::GetFrameIndex() {
+	assert(GetEngine().get());
+	return (uint32_t)(GetEngine()->m_frameNumber % c_maxFramesInFlight);
+}
+
+uint64_t Graphics::GetFrameNumber() {
+	assert(GetEngine().get());
+	return GetEngine()->m_frameNumber;
+}
+
+uint64_t Graphics::GetFramesCompleted() {
+	assert(GetEngine().get());
+	return GetEngine()->m_framesCompleted;
+}
@@ -9,11 +9,17 @@ namespace CR::Graphics {
 	class SpriteManagerBasic;
 
 	vk::Device& GetDevice();
-	uint32_t GetDeviceMemoryIndex();
-	uint32_t GetHostMemoryIndex();
 	const vk::RenderPass& GetRenderPass();
 	const vk::Framebuffer& GetFrameBuffer();
 	uint32_t GetFrameRateDivisor();
+	vk::SampleCountFlagBits GetSampleCount();
+	bool GetSampleShading();
+	// Which copy of per frame buffered resources the current frame should use, 0 to c_maxFramesInFlight-1.
+	uint32_t GetFrameIndex();
+	// Number of the frame currently being recorded, starts at 0.
+	uint64_t GetFrameNumber();
+	// Every frame with a number lower than this has finished executing on the gpu.
+	uint64_t GetFramesCompleted();
 
 	uint32_t GetGraphicsQueueIndex();
 	uint32_t GetTransferQueueIndex();
@@ -24,4 +30,6 @@ namespace CR::Graphics {
 	SpriteManagerBasic& GetSpriteManagerBasic();
 
 	void ExecuteNextFrame(std::function<void()> a_func);
+	// Same as EngineSettings::SkipUnchangedFrames, for changing it after the engine is created.
+	void SetSkipUnchangedFrames(bool a_skip);
 }    // namespace CR::Graphics
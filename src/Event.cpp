@@ -1,13 +1,14 @@
 ﻿#include "Event.h"
 
 #include "EngineInternal.h"
+#include "HostAllocator.h"
 
 using namespace CR::Graphics;
 
 Event::Event() {
-	m_event = GetDevice().createEvent(vk::EventCreateInfo{});
+	m_event = GetDevice().createEvent(vk::EventCreateInfo{}, HostAllocator::Get());
 }
 
 Event::~Event() {
-	if(m_event) { GetDevice().destroyEvent(m_event); }
+	if(m_event) { GetDevice().destroyEvent(m_event, HostAllocator::Get()); }
 }
@@ -0,0 +1,45 @@
+﻿#include "FrameCounters.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+using namespace CR::Graphics;
+
+namespace {
+	atomic_uint64_t g_bytesUploaded{0};
+	atomic_uint32_t g_descriptorWrites{0};
+	atomic_uint32_t g_commandBuffersAllocated{0};
+	atomic_int32_t g_pendingAssetLoads{0};
+	atomic_uint32_t g_hostAllocations{0};
+}    // namespace
+
+void FrameCounters::AddBytesUploaded(uint64_t a_bytes) {
+	g_bytesUploaded.fetch_add(a_bytes, memory_order_relaxed);
+}
+
+void FrameCounters::AddDescriptorWrites(uint32_t a_writes) {
+	g_descriptorWrites.fetch_add(a_writes, memory_order_relaxed);
+}
+
+void FrameCounters::AddCommandBufferAllocated() {
+	g_commandBuffersAllocated.fetch_add(1, memory_order_relaxed);
+}
+
+void FrameCounters::AddPendingAssetLoads(int32_t a_loads) {
+	g_pendingAssetLoads.fetch_add(a_loads, memory_order_relaxed);
+}
+
+void FrameCounters::AddHostAllocation() {
+	g_hostAllocations.fetch_add(1, memory_order_relaxed);
+}
+
+FrameCounters::Counters FrameCounters::TakeCounters() {
+	Counters result;
+	result.BytesUploaded           = g_bytesUploaded.exchange(0, memory_order_relaxed);
+	result.DescriptorWrites        = g_descriptorWrites.exchange(0, memory_order_relaxed);
+	result.CommandBuffersAllocated = g_commandBuffersAllocated.exchange(0, memory_order_relaxed);
+	result.PendingAssetLoads       = (uint32_t)std::max(g_pendingAssetLoads.load(memory_order_relaxed), 0);
+	result.HostAllocations         = g_hostAllocations.exchange(0, memory_order_relaxed);
+	return result;
+}
@@ -0,0 +1,23 @@
+﻿#pragma once
+
+#include <cstdint>
+
+// Counters for Graphics::GetFrameStats that are bumped from all over the engine. Thread safe, and just a relaxed atomic
+// add, so they are always on.
+namespace CR::Graphics::FrameCounters {
+	void AddBytesUploaded(uint64_t a_bytes);
+	void AddDescriptorWrites(uint32_t a_writes);
+	void AddCommandBufferAllocated();
+	void AddPendingAssetLoads(int32_t a_loads);
+	void AddHostAllocation();
+
+	struct Counters {
+		uint64_t BytesUploaded{0};
+		uint32_t DescriptorWrites{0};
+		uint32_t CommandBuffersAllocated{0};
+		uint32_t PendingAssetLoads{0};
+		uint32_t HostAllocations{0};
+	};
+	// Counts since the last call, except PendingAssetLoads which is the current total. Render thread only.
+	[[nodiscard]] Counters TakeCounters();
+}    // namespace CR::Graphics::FrameCounters
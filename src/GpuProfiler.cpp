@@ -0,0 +1,157 @@
+﻿#include "GpuProfiler.h"
+
+#include "CommandPool.h"
+#include "Constants.h"
+#include "EngineInternal.h"
+#include "Graphics/Engine.h"
+#include "HostAllocator.h"
+
+#include "core/Log.h"
+
+#include <atomic>
+#include <limits>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	// includes the fixed phases
+	constexpr uint32_t c_maxScopes       = 32;
+	constexpr uint32_t c_queriesPerFrame = c_maxScopes * 2;
+	constexpr uint32_t c_firstUserScope  = (uint32_t)GpuProfiler::Phase::Count;
+
+	const char* c_phaseNames[] = {"Upload", "Draw", "Resolve"};
+	static_assert(size(c_phaseNames) == c_firstUserScope);
+
+	struct FrameQueries {
+		uint64_t FrameNumber{numeric_limits<uint64_t>::max()};
+		atomic_uint32_t ScopeCount{c_firstUserScope};
+		const char* Names[c_maxScopes]{};
+		bool Used[c_maxScopes]{};
+	};
+
+	vk::Device g_device;
+	vk::QueryPool g_queryPool;
+	bool g_enabled{false};
+	float g_msPerTick{0.0f};
+	uint64_t g_timestampMask{0};
+	FrameQueries g_frames[c_maxFramesInFlight];
+	uint32_t g_currentFrame{0};
+	GpuFrameTimes g_latest;
+
+	uint32_t FirstQuery(uint32_t a_frame, uint32_t a_scope) { return a_frame * c_queriesPerFrame + a_scope * 2; }
+
+	void ReadBack(uint32_t a_frame) {
+		FrameQueries& frame = g_frames[a_frame];
+		if(frame.FrameNumber == numeric_limits<uint64_t>::max()) { return; }
+
+		uint32_t scopeCount = std::min(frame.ScopeCount.load(memory_order_acquire), c_maxScopes);
+		uint64_t results[c_queriesPerFrame];
+		// gpu is already done with this frame, so never waits. Not ready only if a scope was never written.
+		vk::Result result = g_device.getQueryPoolResults(g_queryPool, FirstQuery(a_frame, 0), scopeCount * 2,
+		                                                 sizeof(results), results, sizeof(uint64_t),
+		                                                 vk::QueryResultFlagBits::e64);
+		if(result != vk::Result::eSuccess) { return; }
+
+		auto scopeMs = [&](uint32_t a_scope) {
+			uint64_t begin = results[a_scope * 2] & g_timestampMask;
+			uint64_t end   = results[a_scope * 2 + 1] & g_timestampMask;
+			return end > begin ? (end - begin) * g_msPerTick : 0.0f;
+		};
+
+		g_latest.FrameNumber = frame.FrameNumber;
+		g_latest.UploadMs    = scopeMs((uint32_t)GpuProfiler::Phase::Upload);
+		g_latest.DrawMs      = scopeMs((uint32_t)GpuProfiler::Phase::Draw);
+		g_latest.ResolveMs   = scopeMs((uint32_t)GpuProfiler::Phase::Resolve);
+		uint64_t frameBegin  = results[(uint32_t)GpuProfiler::Phase::Upload * 2] & g_timestampMask;
+		uint64_t frameEnd    = results[(uint32_t)GpuProfiler::Phase::Resolve * 2 + 1] & g_timestampMask;
+		g_latest.TotalMs     = frameEnd > frameBegin ? (frameEnd - frameBegin) * g_msPerTick : 0.0f;
+
+		g_latest.Scopes.clear();
+		for(uint32_t scope = c_firstUserScope; scope < scopeCount; ++scope) {
+			if(!frame.Used[scope]) { continue; }
+			g_latest.Scopes.push_back({frame.Names[scope], scopeMs(scope)});
+		}
+	}
+}    // namespace
+
+void GpuProfiler::Init(const vk::PhysicalDevice& a_physicalDevice, const vk::Device& a_device,
+                       uint32_t a_queueFamily) {
+	g_device = a_device;
+
+	uint32_t validBits = a_physicalDevice.getQueueFamilyProperties()[a_queueFamily].timestampValidBits;
+	if(validBits == 0) {
+		Core::Log::Info("Graphics queue doesn't support timestamps, gpu timings disabled");
+		return;
+	}
+	g_enabled       = true;
+	g_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	g_msPerTick     = a_physicalDevice.getProperties().limits.timestampPeriod / 1'000'000.0f;
+
+	vk::QueryPoolCreateInfo createInfo;
+	createInfo.queryType  = vk::QueryType::eTimestamp;
+	createInfo.queryCount = c_queriesPerFrame * c_maxFramesInFlight;
+	g_queryPool           = g_device.createQueryPool(createInfo, HostAllocator::Get());
+}
+
+void GpuProfiler::Shutdown() {
+	if(g_enabled) { g_device.destroyQueryPool(g_queryPool, HostAllocator::Get()); }
+	g_queryPool = vk::QueryPool{};
+	g_enabled   = false;
+	g_device    = vk::Device{};
+}
+
+void GpuProfiler::BeginFrame(CommandBuffer& a_cmdBuffer) {
+	if(!g_enabled) { return; }
+	g_currentFrame = GetFrameIndex();
+	ReadBack(g_currentFrame);
+
+	FrameQueries& frame = g_frames[g_currentFrame];
+	frame.FrameNumber   = GetFrameNumber();
+	frame.ScopeCount.store(c_firstUserScope, memory_order_relaxed);
+	for(auto& used : frame.Used) { used = false; }
+	for(uint32_t phase = 0; phase < c_firstUserScope; ++phase) {
+		frame.Names[phase] = c_phaseNames[phase];
+		frame.Used[phase]  = true;
+	}
+
+	a_cmdBuffer.GetHandle().resetQueryPool(g_queryPool, FirstQuery(g_currentFrame, 0), c_queriesPerFrame);
+}
+
+// Begin timestamps are bottom of pipe as well, so a phase or scope doesn't start until the work before it is done and
+// back to back ones don't overlap.
+void GpuProfiler::BeginPhase(CommandBuffer& a_cmdBuffer, Phase a_phase) {
+	if(!g_enabled) { return; }
+	a_cmdBuffer.GetHandle().writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, g_queryPool,
+	                                       FirstQuery(g_currentFrame, (uint32_t)a_phase));
+}
+
+void GpuProfiler::EndPhase(CommandBuffer& a_cmdBuffer, Phase a_phase) {
+	if(!g_enabled) { return; }
+	a_cmdBuffer.GetHandle().writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, g_queryPool,
+	                                       FirstQuery(g_currentFrame, (uint32_t)a_phase) + 1);
+}
+
+uint32_t GpuProfiler::BeginScope(CommandBuffer& a_cmdBuffer, const char* a_name) {
+	if(!g_enabled) { return c_invalidScope; }
+	FrameQueries& frame = g_frames[g_currentFrame];
+	uint32_t scope      = frame.ScopeCount.fetch_add(1, memory_order_relaxed);
+	if(scope >= c_maxScopes) { return c_invalidScope; }
+
+	frame.Names[scope] = a_name;
+	frame.Used[scope]  = true;
+	a_cmdBuffer.GetHandle().writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, g_queryPool,
+	                                       FirstQuery(g_currentFrame, scope));
+	return scope;
+}
+
+void GpuProfiler::EndScope(CommandBuffer& a_cmdBuffer, uint32_t a_scope) {
+	if(!g_enabled || a_scope == c_invalidScope) { return; }
+	a_cmdBuffer.GetHandle().writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, g_queryPool,
+	                                       FirstQuery(g_currentFrame, a_scope) + 1);
+}
+
+const GpuFrameTimes& Graphics::GetGpuFrameTimes() {
+	return g_latest;
+}
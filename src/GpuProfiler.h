@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include "VulkanWindows.h"
+
+#include <cstdint>
+
+namespace CR::Graphics {
+	class CommandBuffer;
+}
+
+// Timestamp queries around parts of a frame. Results are read back once the gpu is done with that frame, so they lag a
+// couple of frames behind, and are available from Graphics::GetGpuFrameTimes. Does nothing if the graphics queue
+// doesn't support timestamps.
+namespace CR::Graphics::GpuProfiler {
+	// Fixed scopes the engine times every frame, any other scope is reported by name.
+	enum class Phase : uint32_t { Upload, Draw, Resolve, Count };
+
+	inline constexpr uint32_t c_invalidScope = ~0u;
+
+	void Init(const vk::PhysicalDevice& a_physicalDevice, const vk::Device& a_device, uint32_t a_queueFamily);
+	void Shutdown();
+
+	// Start of every rendered frame, after the gpu is done with the last frame that used this frame index. Reads back
+	// that frames results and resets its queries, so must be first in the primary command buffer.
+	void BeginFrame(CommandBuffer& a_cmdBuffer);
+
+	void BeginPhase(CommandBuffer& a_cmdBuffer, Phase a_phase);
+	void EndPhase(CommandBuffer& a_cmdBuffer, Phase a_phase);
+
+	// a_name must outlive the frame, a string literal is intended. Thread safe, can be used from RecordingThreads.
+	// Returns c_invalidScope if out of scopes this frame, EndScope ignores it.
+	[[nodiscard]] uint32_t BeginScope(CommandBuffer& a_cmdBuffer, const char* a_name);
+	void EndScope(CommandBuffer& a_cmdBuffer, uint32_t a_scope);
+}    // namespace CR::Graphics::GpuProfiler
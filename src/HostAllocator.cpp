@@ -0,0 +1,213 @@
+﻿#include "HostAllocator.h"
+
+#include "FrameCounters.h"
+#include "Graphics/Engine.h"
+
+#include "core/Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	// Sits right in front of every allocation we hand the driver.
+	struct alignas(16) Header {
+		void* Base{nullptr};    // what to give back to free, heap allocations only
+		uint32_t Size{0};
+		uint8_t SizeClass{0};
+		uint8_t Scope{0};
+	};
+	static_assert(sizeof(Header) == 16);
+
+	// Pooled allocations include the header, anything bigger, or more aligned than the header, goes to the heap.
+	constexpr uint32_t c_sizeClasses[] = {64, 128, 256, 512, 1024};
+	constexpr uint8_t c_heap           = (uint8_t)size(c_sizeClasses);
+	constexpr size_t c_chunkSize       = 64 * 1024;
+	constexpr uint32_t c_scopeCount    = (uint32_t)HostAllocationScope::Count;
+	static_assert(c_scopeCount == VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1);
+
+	struct Pool {
+		mutex Mutex;
+		void* FreeList{nullptr};
+		vector<void*> Chunks;
+	};
+
+	struct ScopeCounters {
+		atomic_uint64_t Bytes{0};
+		atomic_uint32_t Allocations{0};
+		atomic_uint64_t TotalAllocations{0};
+		atomic_uint64_t InternalBytes{0};
+	};
+
+	bool g_usePool{false};
+	Pool g_pools[size(c_sizeClasses)];
+	atomic_uint64_t g_pooledBytes{0};
+	ScopeCounters g_scopes[c_scopeCount];
+	vk::AllocationCallbacks g_callbacks;
+
+	uint8_t FindSizeClass(size_t a_size, size_t a_alignment) {
+		if(!g_usePool || a_alignment > alignof(Header)) { return c_heap; }
+		for(uint8_t i = 0; i < c_heap; ++i) {
+			if(a_size + sizeof(Header) <= c_sizeClasses[i]) { return i; }
+		}
+		return c_heap;
+	}
+
+	void* PoolAllocate(uint8_t a_sizeClass) {
+		Pool& pool = g_pools[a_sizeClass];
+		scoped_lock lock(pool.Mutex);
+		if(!pool.FreeList) {
+			auto* chunk = (std::byte*)malloc(c_chunkSize);
+			if(!chunk) { return nullptr; }
+			pool.Chunks.push_back(chunk);
+			g_pooledBytes.fetch_add(c_chunkSize, memory_order_relaxed);
+			// malloc is aligned well enough for the header, and every size class is a multiple of it.
+			for(size_t offset = 0; offset + c_sizeClasses[a_sizeClass] <= c_chunkSize;
+			    offset += c_sizeClasses[a_sizeClass]) {
+				*(void**)(chunk + offset) = pool.FreeList;
+				pool.FreeList             = chunk + offset;
+			}
+		}
+		void* result  = pool.FreeList;
+		pool.FreeList = *(void**)result;
+		return result;
+	}
+
+	void PoolFree(uint8_t a_sizeClass, void* a_block) {
+		Pool& pool = g_pools[a_sizeClass];
+		scoped_lock lock(pool.Mutex);
+		*(void**)a_block = pool.FreeList;
+		pool.FreeList    = a_block;
+	}
+
+	void* Allocate(size_t a_size, size_t a_alignment, VkSystemAllocationScope a_scope) {
+		if(a_size == 0 || a_size > numeric_limits<uint32_t>::max()) { return nullptr; }
+		a_alignment = std::max(a_alignment, alignof(Header));
+
+		uint8_t sizeClass = FindSizeClass(a_size, a_alignment);
+		std::byte* result = nullptr;
+		void* base        = nullptr;
+		if(sizeClass != c_heap) {
+			base = PoolAllocate(sizeClass);
+			if(!base) { return nullptr; }
+			result = (std::byte*)base + sizeof(Header);
+			base   = nullptr;
+		} else {
+			base = malloc(a_size + a_alignment + sizeof(Header));
+			if(!base) { return nullptr; }
+			auto address = (uintptr_t)base + sizeof(Header);
+			result       = (std::byte*)((address + a_alignment - 1) & ~(uintptr_t)(a_alignment - 1));
+		}
+
+		Header& header   = *((Header*)result - 1);
+		header.Base      = base;
+		header.Size      = (uint32_t)a_size;
+		header.SizeClass = sizeClass;
+		header.Scope     = (uint8_t)a_scope;
+
+		ScopeCounters& counters = g_scopes[a_scope];
+		counters.Bytes.fetch_add(a_size, memory_order_relaxed);
+		counters.Allocations.fetch_add(1, memory_order_relaxed);
+		counters.TotalAllocations.fetch_add(1, memory_order_relaxed);
+		FrameCounters::AddHostAllocation();
+		return result;
+	}
+
+	void Free(void* a_memory) {
+		if(!a_memory) { return; }
+		const Header& header    = *((Header*)a_memory - 1);
+		ScopeCounters& counters = g_scopes[header.Scope];
+		counters.Bytes.fetch_sub(header.Size, memory_order_relaxed);
+		counters.Allocations.fetch_sub(1, memory_order_relaxed);
+
+		if(header.SizeClass != c_heap) {
+			PoolFree(header.SizeClass, (std::byte*)a_memory - sizeof(Header));
+		} else {
+			free(header.Base);
+		}
+	}
+
+	VKAPI_ATTR void* VKAPI_CALL AllocationFunc(void*, size_t a_size, size_t a_alignment,
+	                                           VkSystemAllocationScope a_scope) {
+		return Allocate(a_size, a_alignment, a_scope);
+	}
+
+	VKAPI_ATTR void* VKAPI_CALL ReallocationFunc(void*, void* a_original, size_t a_size, size_t a_alignment,
+	                                             VkSystemAllocationScope a_scope) {
+		if(!a_original) { return Allocate(a_size, a_alignment, a_scope); }
+		if(a_size == 0) {
+			Free(a_original);
+			return nullptr;
+		}
+		void* result = Allocate(a_size, a_alignment, a_scope);
+		// on failure the original must be left alone
+		if(!result) { return nullptr; }
+		const Header& header = *((Header*)a_original - 1);
+		memcpy(result, a_original, std::min<size_t>(header.Size, a_size));
+		Free(a_original);
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL FreeFunc(void*, void* a_memory) { Free(a_memory); }
+
+	VKAPI_ATTR void VKAPI_CALL InternalAllocationNotification(void*, size_t a_size, VkInternalAllocationType,
+	                                                          VkSystemAllocationScope a_scope) {
+		g_scopes[a_scope].InternalBytes.fetch_add(a_size, memory_order_relaxed);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL InternalFreeNotification(void*, size_t a_size, VkInternalAllocationType,
+	                                                    VkSystemAllocationScope a_scope) {
+		g_scopes[a_scope].InternalBytes.fetch_sub(a_size, memory_order_relaxed);
+	}
+}    // namespace
+
+void HostAllocator::Init(bool a_usePool) {
+	g_usePool                         = a_usePool;
+	g_callbacks.pUserData             = nullptr;
+	g_callbacks.pfnAllocation         = &AllocationFunc;
+	g_callbacks.pfnReallocation       = &ReallocationFunc;
+	g_callbacks.pfnFree               = &FreeFunc;
+	g_callbacks.pfnInternalAllocation = &InternalAllocationNotification;
+	g_callbacks.pfnInternalFree       = &InternalFreeNotification;
+}
+
+void HostAllocator::Shutdown() {
+	uint64_t leaked = 0;
+	for(const auto& scope : g_scopes) { leaked += scope.Allocations.load(memory_order_relaxed); }
+	if(leaked > 0) { Log::Warn("driver still holds {} host allocations after the instance was destroyed", leaked); }
+
+	// Only safe to hand chunks back if nothing still points into them.
+	if(leaked == 0) {
+		for(auto& pool : g_pools) {
+			for(void* chunk : pool.Chunks) { free(chunk); }
+			pool.Chunks.clear();
+			pool.FreeList = nullptr;
+		}
+		g_pooledBytes.store(0, memory_order_relaxed);
+	}
+}
+
+const vk::AllocationCallbacks* HostAllocator::Get() {
+	return &g_callbacks;
+}
+
+HostMemoryStats Graphics::GetHostMemoryStats() {
+	HostMemoryStats result;
+	for(uint32_t i = 0; i < c_scopeCount; ++i) {
+		result.Scopes[i].Bytes            = g_scopes[i].Bytes.load(memory_order_relaxed);
+		result.Scopes[i].Allocations      = g_scopes[i].Allocations.load(memory_order_relaxed);
+		result.Scopes[i].TotalAllocations = g_scopes[i].TotalAllocations.load(memory_order_relaxed);
+		result.Scopes[i].InternalBytes    = g_scopes[i].InternalBytes.load(memory_order_relaxed);
+	}
+	result.PooledBytes = g_pooledBytes.load(memory_order_relaxed);
+	return result;
+}
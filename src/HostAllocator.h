@@ -0,0 +1,14 @@
+﻿#pragma once
+
+#include "VulkanWindows.h"
+
+// vk::AllocationCallbacks for the driver's cpu side allocations, pass Get() to every create and destroy call so they
+// show up in Graphics::GetHostMemoryStats. Optionally serves small allocations out of size class pools instead of the
+// heap. Thread safe, the driver calls these from whatever thread is calling into it.
+namespace CR::Graphics::HostAllocator {
+	// Must be called before the instance is created, and Shutdown after it is destroyed.
+	void Init(bool a_usePool);
+	void Shutdown();
+
+	[[nodiscard]] const vk::AllocationCallbacks* Get();
+}    // namespace CR::Graphics::HostAllocator
@@ -0,0 +1,336 @@
+﻿#include "MemoryAllocator.h"
+
+#include "HostAllocator.h"
+
+#include "core/Log.h"
+#include "core/literals.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+using namespace CR::Core::Literals;
+
+namespace {
+	constexpr vk::DeviceSize c_blockSize{64_Mb};
+	// anything at least this big gets its own allocation, would waste too much of a block otherwise.
+	constexpr vk::DeviceSize c_dedicatedThreshold{c_blockSize / 2};
+
+	// A memory type matches a tier if it has all of Required, and none of Avoid. Tiers are tried in order.
+	struct MemoryTier {
+		vk::MemoryPropertyFlags Required;
+		vk::MemoryPropertyFlags Avoid;
+	};
+	using MemFlags = vk::MemoryPropertyFlagBits;
+
+	const vector<MemoryTier> c_gpuOnlyTiers{{MemFlags::eDeviceLocal, MemFlags::eHostVisible},
+	                                        {MemFlags::eDeviceLocal, {}},
+	                                        {{}, {}}};
+	const vector<MemoryTier> c_uploadTiers{{MemFlags::eHostVisible | MemFlags::eHostCoherent, MemFlags::eDeviceLocal},
+	                                       {MemFlags::eHostVisible | MemFlags::eHostCoherent, {}}};
+	const vector<MemoryTier> c_streamTiers{
+	    {MemFlags::eDeviceLocal | MemFlags::eHostVisible | MemFlags::eHostCoherent, {}},
+	    {MemFlags::eHostVisible | MemFlags::eHostCoherent, {}}};
+	// we never flush or invalidate, so host visible memory always has to be coherent.
+	const vector<MemoryTier> c_readbackTiers{
+	    {MemFlags::eHostVisible | MemFlags::eHostCoherent | MemFlags::eHostCached, {}},
+	    {MemFlags::eHostVisible | MemFlags::eHostCoherent, {}}};
+	const vector<MemoryTier> c_transientTiers{{MemFlags::eDeviceLocal | MemFlags::eLazilyAllocated, {}},
+	                                          {MemFlags::eDeviceLocal, MemFlags::eHostVisible},
+	                                          {MemFlags::eDeviceLocal, {}}};
+
+	const vector<MemoryTier>& GetTiers(MemoryUsage a_usage) {
+		switch(a_usage) {
+			case MemoryUsage::GpuOnly:
+				return c_gpuOnlyTiers;
+			case MemoryUsage::Upload:
+				return c_uploadTiers;
+			case MemoryUsage::Stream:
+				return c_streamTiers;
+			case MemoryUsage::Readback:
+				return c_readbackTiers;
+			case MemoryUsage::Transient:
+				return c_transientTiers;
+			default:
+				Core::Log::Require(false, "Unknown memory usage");
+				return c_gpuOnlyTiers;
+		}
+	}
+
+	struct FreeRange {
+		vk::DeviceSize Offset{0};
+		vk::DeviceSize Size{0};
+	};
+
+	struct Block {
+		vk::DeviceMemory Memory;
+		std::byte* Data{nullptr};
+		uint32_t MemoryType{0};
+		vk::DeviceSize Size{0};
+		vk::DeviceSize Used{0};
+		// sorted by offset, neighbouring ranges are always merged
+		vector<FreeRange> FreeRanges;
+	};
+
+	vk::Device g_device;
+	vk::PhysicalDeviceMemoryProperties g_memProps;
+	vk::DeviceSize g_granularity{1};
+	uint32_t g_maxAllocations{0};
+	uint32_t g_numAllocations{0};
+	mutex g_mutex;
+	// released blocks leave a hole with a null Memory handle, so Block indices in live allocations stay valid.
+	vector<Block> g_blocks;
+
+	vk::DeviceSize AlignUp(vk::DeviceSize a_value, vk::DeviceSize a_alignment) {
+		return (a_value + a_alignment - 1) & ~(a_alignment - 1);
+	}
+
+	bool IsHostVisible(uint32_t a_memoryType) {
+		return (bool)(g_memProps.memoryTypes[a_memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+	}
+
+	// Blocks are capped to a fraction of their heap, some heaps(i.e. 256MB ReBAR) are small.
+	vk::DeviceSize GetBlockSize(uint32_t a_memoryType) {
+		vk::DeviceSize heapSize = g_memProps.memoryHeaps[g_memProps.memoryTypes[a_memoryType].heapIndex].size;
+		return std::min(c_blockSize, AlignUp(heapSize / 8, g_granularity));
+	}
+
+	// all of the following must be called with g_mutex held
+	vk::DeviceMemory AllocateDeviceMemory(vk::DeviceSize a_size, uint32_t a_memoryType, const void* a_next) {
+		Core::Log::Require(g_numAllocations < g_maxAllocations, "Ran out of device memory allocations, max is {}",
+		                   g_maxAllocations);
+
+		vk::MemoryAllocateInfo allocInfo;
+		allocInfo.pNext           = a_next;
+		allocInfo.memoryTypeIndex = a_memoryType;
+		allocInfo.allocationSize  = a_size;
+		++g_numAllocations;
+		return g_device.allocateMemory(allocInfo, HostAllocator::Get());
+	}
+
+	void FreeDeviceMemory(const vk::DeviceMemory& a_memory, bool a_mapped) {
+		if(a_mapped) { g_device.unmapMemory(a_memory); }
+		g_device.freeMemory(a_memory, HostAllocator::Get());
+		--g_numAllocations;
+	}
+
+	Allocation AllocateDedicated(const vk::MemoryRequirements& a_requirements, uint32_t a_memoryType,
+	                             const vk::MemoryDedicatedAllocateInfo& a_dedicatedInfo) {
+		Allocation result;
+		result.Memory     = AllocateDeviceMemory(a_requirements.size, a_memoryType, &a_dedicatedInfo);
+		result.Size       = a_requirements.size;
+		result.MemoryType = a_memoryType;
+		result.Block      = Allocation::c_dedicated;
+		if(IsHostVisible(a_memoryType)) {
+			result.Data = (std::byte*)g_device.mapMemory(result.Memory, 0, VK_WHOLE_SIZE);
+		}
+		return result;
+	}
+
+	// First fit. Any padding needed for alignment is left behind as its own free range.
+	bool SubAllocate(Block& a_block, vk::DeviceSize a_size, vk::DeviceSize a_alignment, vk::DeviceSize& a_offset) {
+		for(size_t i = 0; i < a_block.FreeRanges.size(); ++i) {
+			FreeRange& range       = a_block.FreeRanges[i];
+			vk::DeviceSize offset  = AlignUp(range.Offset, a_alignment);
+			vk::DeviceSize padding = offset - range.Offset;
+			if(range.Size < padding + a_size) { continue; }
+
+			FreeRange trailing{offset + a_size, range.Offset + range.Size - (offset + a_size)};
+			if(padding > 0) {
+				range.Size = padding;
+				if(trailing.Size > 0) { a_block.FreeRanges.insert(begin(a_block.FreeRanges) + i + 1, trailing); }
+			} else if(trailing.Size > 0) {
+				range = trailing;
+			} else {
+				a_block.FreeRanges.erase(begin(a_block.FreeRanges) + i);
+			}
+
+			a_block.Used += a_size;
+			a_offset = offset;
+			return true;
+		}
+		return false;
+	}
+
+	void ReleaseRange(Block& a_block, vk::DeviceSize a_offset, vk::DeviceSize a_size) {
+		auto byOffset = [](const FreeRange& a_range, vk::DeviceSize a_value) { return a_range.Offset < a_value; };
+		auto iter     = lower_bound(begin(a_block.FreeRanges), end(a_block.FreeRanges), a_offset, byOffset);
+		iter          = a_block.FreeRanges.insert(iter, FreeRange{a_offset, a_size});
+
+		auto next = iter + 1;
+		if(next != end(a_block.FreeRanges) && iter->Offset + iter->Size == next->Offset) {
+			iter->Size += next->Size;
+			a_block.FreeRanges.erase(next);
+		}
+		if(iter != begin(a_block.FreeRanges)) {
+			auto prev = iter - 1;
+			if(prev->Offset + prev->Size == iter->Offset) {
+				prev->Size += iter->Size;
+				a_block.FreeRanges.erase(iter);
+			}
+		}
+		a_block.Used -= a_size;
+	}
+
+	uint32_t CreateBlock(uint32_t a_memoryType, vk::DeviceSize a_minSize) {
+		uint32_t blockIndex = (uint32_t)g_blocks.size();
+		for(uint32_t i = 0; i < g_blocks.size(); ++i) {
+			if(!g_blocks[i].Memory) {
+				blockIndex = i;
+				break;
+			}
+		}
+		if(blockIndex == g_blocks.size()) { g_blocks.emplace_back(); }
+
+		Block& block     = g_blocks[blockIndex];
+		block.MemoryType = a_memoryType;
+		block.Size       = std::max(GetBlockSize(a_memoryType), a_minSize);
+		block.Used       = 0;
+		block.Memory     = AllocateDeviceMemory(block.Size, a_memoryType, nullptr);
+		block.Data       = nullptr;
+		if(IsHostVisible(a_memoryType)) { block.Data = (std::byte*)g_device.mapMemory(block.Memory, 0, VK_WHOLE_SIZE); }
+		block.FreeRanges.clear();
+		block.FreeRanges.push_back(FreeRange{0, block.Size});
+
+		return blockIndex;
+	}
+
+	Allocation AllocateInternal(const vk::MemoryRequirements& a_requirements, uint32_t a_memoryType,
+	                            bool a_wantsDedicated, const vk::MemoryDedicatedAllocateInfo& a_dedicatedInfo) {
+		Core::Log::Assert(a_memoryType < g_memProps.memoryTypeCount, "invalid memory type {}", a_memoryType);
+		lock_guard<mutex> lock(g_mutex);
+
+		if(a_wantsDedicated || a_requirements.size >= c_dedicatedThreshold) {
+			return AllocateDedicated(a_requirements, a_memoryType, a_dedicatedInfo);
+		}
+
+		// Aligning everything to bufferImageGranularity lets buffers and optimal images share a block safely.
+		vk::DeviceSize alignment = std::max(a_requirements.alignment, g_granularity);
+		vk::DeviceSize size      = AlignUp(a_requirements.size, g_granularity);
+
+		Allocation result;
+		result.Size       = size;
+		result.MemoryType = a_memoryType;
+
+		for(uint32_t i = 0; i < g_blocks.size(); ++i) {
+			Block& block = g_blocks[i];
+			if(!block.Memory || block.MemoryType != a_memoryType || block.Size - block.Used < size) { continue; }
+			if(SubAllocate(block, size, alignment, result.Offset)) {
+				result.Memory = block.Memory;
+				result.Block  = i;
+				if(block.Data) { result.Data = block.Data + result.Offset; }
+				return result;
+			}
+		}
+
+		uint32_t blockIndex = CreateBlock(a_memoryType, size);
+		Block& block        = g_blocks[blockIndex];
+		[[maybe_unused]] bool allocated = SubAllocate(block, size, alignment, result.Offset);
+		Core::Log::Assert(allocated, "new memory block was too small");
+		result.Memory = block.Memory;
+		result.Block  = blockIndex;
+		if(block.Data) { result.Data = block.Data + result.Offset; }
+		return result;
+	}
+}    // namespace
+
+void MemoryAllocator::Init(const vk::PhysicalDevice& a_physicalDevice, const vk::Device& a_device) {
+	g_device         = a_device;
+	g_memProps       = a_physicalDevice.getMemoryProperties();
+	auto props       = a_physicalDevice.getProperties();
+	g_granularity    = std::max<vk::DeviceSize>(props.limits.bufferImageGranularity, 1);
+	g_maxAllocations = props.limits.maxMemoryAllocationCount;
+	g_numAllocations = 0;
+}
+
+void MemoryAllocator::Shutdown() {
+	lock_guard<mutex> lock(g_mutex);
+	for(auto& block : g_blocks) {
+		if(!block.Memory) { continue; }
+		Core::Log::Assert(block.Used == 0, "Not all device memory was freed before shutdown");
+		FreeDeviceMemory(block.Memory, block.Data != nullptr);
+	}
+	g_blocks.clear();
+	Core::Log::Assert(g_numAllocations == 0, "Not all dedicated device memory was freed before shutdown");
+	g_device = vk::Device{};
+}
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t a_memoryTypeBits, MemoryUsage a_usage) {
+	for(const auto& tier : GetTiers(a_usage)) {
+		for(uint32_t i = 0; i < g_memProps.memoryTypeCount; ++i) {
+			if(!(a_memoryTypeBits & (1 << i))) { continue; }
+			const auto& flags = g_memProps.memoryTypes[i].propertyFlags;
+			if((flags & tier.Required) == tier.Required && !(flags & tier.Avoid)) { return i; }
+		}
+	}
+	Core::Log::Require(false, "Could not find a valid memory type for this resource");
+	return 0;
+}
+
+vk::MemoryPropertyFlags MemoryAllocator::GetMemoryFlags(uint32_t a_memoryType) {
+	return g_memProps.memoryTypes[a_memoryType].propertyFlags;
+}
+
+Allocation MemoryAllocator::Allocate(const vk::Buffer& a_buffer, MemoryUsage a_usage) {
+	vk::BufferMemoryRequirementsInfo2 reqInfo;
+	reqInfo.buffer = a_buffer;
+	auto requirements =
+	    g_device.getBufferMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(reqInfo);
+	const auto& dedicatedReqs = requirements.get<vk::MemoryDedicatedRequirements>();
+
+	vk::MemoryDedicatedAllocateInfo dedicatedInfo;
+	dedicatedInfo.buffer = a_buffer;
+
+	const auto& memoryReqs = requirements.get<vk::MemoryRequirements2>().memoryRequirements;
+	uint32_t memoryType    = FindMemoryType(memoryReqs.memoryTypeBits, a_usage);
+	bool dedicated         = dedicatedReqs.prefersDedicatedAllocation || dedicatedReqs.requiresDedicatedAllocation;
+	Allocation result      = AllocateInternal(memoryReqs, memoryType, dedicated, dedicatedInfo);
+	g_device.bindBufferMemory(a_buffer, result.Memory, result.Offset);
+	return result;
+}
+
+Allocation MemoryAllocator::Allocate(const vk::Image& a_image, MemoryUsage a_usage) {
+	vk::ImageMemoryRequirementsInfo2 reqInfo;
+	reqInfo.image = a_image;
+	auto requirements =
+	    g_device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(reqInfo);
+	const auto& dedicatedReqs = requirements.get<vk::MemoryDedicatedRequirements>();
+
+	vk::MemoryDedicatedAllocateInfo dedicatedInfo;
+	dedicatedInfo.image = a_image;
+
+	const auto& memoryReqs = requirements.get<vk::MemoryRequirements2>().memoryRequirements;
+	uint32_t memoryType    = FindMemoryType(memoryReqs.memoryTypeBits, a_usage);
+	bool dedicated         = dedicatedReqs.prefersDedicatedAllocation || dedicatedReqs.requiresDedicatedAllocation;
+	Allocation result      = AllocateInternal(memoryReqs, memoryType, dedicated, dedicatedInfo);
+	g_device.bindImageMemory(a_image, result.Memory, result.Offset);
+	return result;
+}
+
+void MemoryAllocator::Free(Allocation& a_allocation) {
+	if(!a_allocation) { return; }
+
+	lock_guard<mutex> lock(g_mutex);
+	if(a_allocation.Block == Allocation::c_dedicated) {
+		FreeDeviceMemory(a_allocation.Memory, a_allocation.Data != nullptr);
+	} else {
+		Block& block = g_blocks[a_allocation.Block];
+		ReleaseRange(block, a_allocation.Offset, a_allocation.Size);
+
+		// Keep one block of each type around even when empty, so destroying and recreating a resource doesn't go
+		// back to the driver every time.
+		if(block.Used == 0) {
+			bool hasOtherBlock = any_of(begin(g_blocks), end(g_blocks), [&](const Block& a_other) {
+				return a_other.Memory && &a_other != &block && a_other.MemoryType == block.MemoryType;
+			});
+			if(hasOtherBlock) {
+				FreeDeviceMemory(block.Memory, block.Data != nullptr);
+				block = Block{};
+			}
+		}
+	}
+	a_allocation = Allocation{};
+}
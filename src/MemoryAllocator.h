@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include "VulkanWindows.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace CR::Graphics {
+	// A piece of device memory handed out by the MemoryAllocator. Resources must be bound at Memory + Offset. Data is
+	// only set for host visible memory, and already points at Offset. Host visible memory stays mapped for its whole
+	// life, never map it yourself.
+	struct Allocation {
+		inline static constexpr uint32_t c_dedicated{std::numeric_limits<uint32_t>::max()};
+
+		vk::DeviceMemory Memory;
+		vk::DeviceSize Offset{0};
+		vk::DeviceSize Size{0};
+		std::byte* Data{nullptr};
+		uint32_t MemoryType{0};
+		uint32_t Block{c_dedicated};
+
+		explicit operator bool() const { return (bool)Memory; }
+	};
+
+	// How a resource is going to be used, picks the fastest memory type the resource is allowed to live in.
+	enum class MemoryUsage {
+		GpuOnly,      // Never touched by the cpu. Device local.
+		Upload,       // Written once by the cpu, then copied from. Host visible, avoids using up ReBAR space.
+		Stream,       // Written by the cpu every frame, read by the gpu. Prefers device local + host visible(ReBAR).
+		Readback,     // Written by the gpu, read by the cpu. Prefers host cached.
+		Transient,    // Attachments that never need to leave tile memory. Prefers lazily allocated.
+	};
+}    // namespace CR::Graphics
+
+// Sub allocates resources out of large per memory type blocks, so creating and destroying resources doesn't hit the
+// driver, and we stay well under maxMemoryAllocationCount. Large resources, and ones the driver asks for, get a
+// dedicated allocation instead. Thread safe.
+namespace CR::Graphics::MemoryAllocator {
+	void Init(const vk::PhysicalDevice& a_physicalDevice, const vk::Device& a_device);
+	void Shutdown();
+
+	// Best memory type out of a_memoryTypeBits(from the resources memory requirements) for the given usage.
+	[[nodiscard]] uint32_t FindMemoryType(uint32_t a_memoryTypeBits, MemoryUsage a_usage);
+	[[nodiscard]] vk::MemoryPropertyFlags GetMemoryFlags(uint32_t a_memoryType);
+
+	// Allocates memory for, and binds it to, the resource.
+	[[nodiscard]] Allocation Allocate(const vk::Buffer& a_buffer, MemoryUsage a_usage);
+	[[nodiscard]] Allocation Allocate(const vk::Image& a_image, MemoryUsage a_usage);
+
+	void Free(Allocation& a_allocation);
+}    // namespace CR::Graphics::MemoryAllocator
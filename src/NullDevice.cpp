@@ -0,0 +1,738 @@
+﻿#include "NullDevice.h"
+
+#include <3rdParty/robinmap.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+using namespace std;
+using namespace CR::Graphics;
+
+namespace {
+	constexpr uint32_t c_graphicsFamily = 0;
+	constexpr uint32_t c_transferFamily = 1;
+	constexpr uint32_t c_deviceLocal    = 0;
+	constexpr uint32_t c_hostVisible    = 1;
+	constexpr VkDeviceSize c_heapSize   = 4ull * 1024 * 1024 * 1024;
+	constexpr VkDeviceSize c_alignment  = 256;
+
+	// Dispatchable handles only need to be unique, nothing ever looks through them.
+	const VkPhysicalDevice g_physicalDevice = (VkPhysicalDevice)(uintptr_t)1;
+	const VkQueue g_queues[]                = {(VkQueue)(uintptr_t)2, (VkQueue)(uintptr_t)3};
+	atomic_uint64_t g_nextHandle{0x1000};
+
+	struct Swapchain {
+		vector<VkImage> Images;
+		uint32_t NextImage{0};
+	};
+
+	mutex g_mutex;
+	// all guarded by g_mutex
+	tsl::robin_map<uint64_t, VkDeviceSize> g_resourceSizes;    // buffers and images
+	tsl::robin_map<uint64_t, std::byte*> g_memory;             // null if not host visible
+	tsl::robin_map<uint64_t, Swapchain> g_swapchains;
+	vector<NullDevice::Command> g_commandLog;
+
+	template<typename T>
+	T NewHandle() {
+		return (T)(uintptr_t)g_nextHandle.fetch_add(1, memory_order_relaxed);
+	}
+
+	template<typename T>
+	uint64_t Key(T a_handle) {
+		return (uint64_t)(uintptr_t)a_handle;
+	}
+
+	// The usual vulkan two call idiom.
+	template<typename T>
+	VkResult Enumerate(uint32_t* a_count, T* a_out, const T* a_values, uint32_t a_valueCount) {
+		if(!a_out) {
+			*a_count = a_valueCount;
+			return VK_SUCCESS;
+		}
+		uint32_t count = std::min(*a_count, a_valueCount);
+		copy(a_values, a_values + count, a_out);
+		*a_count = count;
+		return count < a_valueCount ? VK_INCOMPLETE : VK_SUCCESS;
+	}
+
+	void LogCommand(const char* a_name, VkCommandBuffer a_cmdBuffer) {
+		scoped_lock lock(g_mutex);
+		if(g_commandLog.size() < NullDevice::c_maxLoggedCommands) {
+			g_commandLog.push_back({a_name, vk::CommandBuffer(a_cmdBuffer)});
+		}
+	}
+
+	template<typename Info, typename Handle>
+	VKAPI_ATTR VkResult VKAPI_CALL Create(VkDevice, const Info*, const VkAllocationCallbacks*, Handle* a_handle) {
+		*a_handle = NewHandle<Handle>();
+		return VK_SUCCESS;
+	}
+
+	template<typename Handle>
+	VKAPI_ATTR void VKAPI_CALL Destroy(VkDevice, Handle, const VkAllocationCallbacks*) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL Success(VkDevice) {
+		return VK_SUCCESS;
+	}
+
+	// instance
+
+	VKAPI_ATTR VkResult VKAPI_CALL EnumerateInstanceVersion(uint32_t* a_version) {
+		*a_version = VK_API_VERSION_1_2;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL EnumerateLayerProperties(uint32_t* a_count, VkLayerProperties*) {
+		*a_count = 0;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL EnumerateDeviceLayerProperties(VkPhysicalDevice, uint32_t* a_count,
+	                                                              VkLayerProperties*) {
+		*a_count = 0;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL EnumerateInstanceExtensionProperties(const char*, uint32_t* a_count,
+	                                                                    VkExtensionProperties*) {
+		*a_count = 0;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL EnumerateDeviceExtensionProperties(VkPhysicalDevice, const char*,
+	                                                                  uint32_t* a_count, VkExtensionProperties*) {
+		*a_count = 0;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo*, const VkAllocationCallbacks*,
+	                                              VkInstance* a_instance) {
+		*a_instance = NewHandle<VkInstance>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL DestroyInstance(VkInstance, const VkAllocationCallbacks*) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL EnumeratePhysicalDevices(VkInstance, uint32_t* a_count,
+	                                                        VkPhysicalDevice* a_devices) {
+		return Enumerate(a_count, a_devices, &g_physicalDevice, 1);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties* a_props) {
+		constexpr char name[]  = "Null Device";
+		*a_props               = VkPhysicalDeviceProperties{};
+		a_props->apiVersion    = VK_API_VERSION_1_2;
+		a_props->driverVersion = 1;
+		a_props->deviceType    = VK_PHYSICAL_DEVICE_TYPE_CPU;
+		memcpy(a_props->deviceName, name, sizeof(name));
+
+		VkPhysicalDeviceLimits& limits            = a_props->limits;
+		limits.maxImageDimension2D                = 16384;
+		limits.maxImageArrayLayers                = 2048;
+		limits.maxUniformBufferRange              = 65536;
+		limits.maxStorageBufferRange              = 1u << 30;
+		limits.maxPushConstantsSize               = 128;
+		limits.maxMemoryAllocationCount           = 4096;
+		limits.maxSamplerAllocationCount          = 4000;
+		limits.bufferImageGranularity             = 1;
+		limits.maxBoundDescriptorSets             = 8;
+		limits.maxPerStageDescriptorSampledImages = 1u << 20;
+		limits.maxDescriptorSetSampledImages      = 1u << 20;
+		limits.maxVertexInputAttributes           = 32;
+		limits.maxVertexInputBindings             = 32;
+		limits.maxColorAttachments                = 8;
+		limits.maxViewports                       = 1;
+		limits.maxViewportDimensions[0]           = 16384;
+		limits.maxViewportDimensions[1]           = 16384;
+		limits.maxFramebufferWidth                = 16384;
+		limits.maxFramebufferHeight               = 16384;
+		limits.maxFramebufferLayers               = 2048;
+		limits.minMemoryMapAlignment              = 64;
+		limits.minUniformBufferOffsetAlignment    = c_alignment;
+		limits.minStorageBufferOffsetAlignment    = c_alignment;
+		limits.nonCoherentAtomSize                = 64;
+		limits.optimalBufferCopyOffsetAlignment   = 1;
+		limits.optimalBufferCopyRowPitchAlignment = 1;
+		limits.timestampPeriod                    = 1.0f;
+		limits.framebufferColorSampleCounts =
+		    VK_SAMPLE_COUNT_1_BIT | VK_SAMPLE_COUNT_2_BIT | VK_SAMPLE_COUNT_4_BIT | VK_SAMPLE_COUNT_8_BIT;
+		limits.sampledImageColorSampleCounts      = limits.framebufferColorSampleCounts;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceFeatures(VkPhysicalDevice, VkPhysicalDeviceFeatures* a_features) {
+		// every member is a VkBool32, support everything.
+		auto* features = (VkBool32*)a_features;
+		fill(features, features + sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32), VK_TRUE);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceMemoryProperties(VkPhysicalDevice,
+	                                                             VkPhysicalDeviceMemoryProperties* a_props) {
+		constexpr VkMemoryPropertyFlags hostFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		                                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+		                                            VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+		*a_props                            = VkPhysicalDeviceMemoryProperties{};
+		a_props->memoryHeapCount            = 2;
+		a_props->memoryHeaps[0]             = {c_heapSize, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT};
+		a_props->memoryHeaps[1]             = {c_heapSize, 0};
+		a_props->memoryTypeCount            = 2;
+		a_props->memoryTypes[c_deviceLocal] = {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0};
+		a_props->memoryTypes[c_hostVisible] = {hostFlags, 1};
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice, uint32_t* a_count,
+	                                                                  VkQueueFamilyProperties* a_props) {
+		// no timestampValidBits, so the gpu profiler turns itself off
+		VkQueueFamilyProperties families[2]{};
+		families[c_graphicsFamily].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+		families[c_transferFamily].queueFlags = VK_QUEUE_TRANSFER_BIT;
+		for(auto& family : families) {
+			family.queueCount                  = 1;
+			family.minImageTransferGranularity = {1, 1, 1};
+		}
+		Enumerate(a_count, a_props, families, 2);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice, uint32_t a_family,
+	                                                                  VkSurfaceKHR, VkBool32* a_supported) {
+		*a_supported = a_family == c_graphicsFamily;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice, VkSurfaceKHR,
+	                                                                       VkSurfaceCapabilitiesKHR* a_caps) {
+		*a_caps                         = VkSurfaceCapabilitiesKHR{};
+		a_caps->minImageCount           = 2;
+		a_caps->maxImageCount           = 8;
+		a_caps->currentExtent           = NullDevice::c_surfaceExtent;
+		a_caps->minImageExtent          = {1, 1};
+		a_caps->maxImageExtent          = {16384, 16384};
+		a_caps->maxImageArrayLayers     = 1;
+		a_caps->supportedTransforms     = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+		a_caps->currentTransform        = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+		a_caps->supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		a_caps->supportedUsageFlags     = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice, VkSurfaceKHR,
+	                                                                  uint32_t* a_count,
+	                                                                  VkSurfaceFormatKHR* a_formats) {
+		const VkSurfaceFormatKHR format{VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+		return Enumerate(a_count, a_formats, &format, 1);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice, VkSurfaceKHR,
+	                                                                       uint32_t* a_count,
+	                                                                       VkPresentModeKHR* a_modes) {
+		const VkPresentModeKHR modes[] = {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+		                                  VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+		return Enumerate(a_count, a_modes, modes, (uint32_t)size(modes));
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateWin32SurfaceKHR(VkInstance, const VkWin32SurfaceCreateInfoKHR*,
+	                                                     const VkAllocationCallbacks*, VkSurfaceKHR* a_surface) {
+		*a_surface = NewHandle<VkSurfaceKHR>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL DestroySurfaceKHR(VkInstance, VkSurfaceKHR, const VkAllocationCallbacks*) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice, const VkDeviceCreateInfo*,
+	                                            const VkAllocationCallbacks*, VkDevice* a_device) {
+		*a_device = NewHandle<VkDevice>();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice, const VkAllocationCallbacks*) {
+		scoped_lock lock(g_mutex);
+		for(auto& [memory, data] : g_memory) { free(data); }
+		g_memory.clear();
+		g_resourceSizes.clear();
+		g_swapchains.clear();
+	}
+
+	// queues, the gpu finishes everything the moment it is submitted
+
+	VKAPI_ATTR void VKAPI_CALL GetDeviceQueue(VkDevice, uint32_t a_family, uint32_t, VkQueue* a_queue) {
+		*a_queue = g_queues[a_family];
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL QueueSubmit(VkQueue, uint32_t, const VkSubmitInfo*, VkFence) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL QueueWaitIdle(VkQueue) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL WaitForFences(VkDevice, uint32_t, const VkFence*, VkBool32, uint64_t) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL ResetFences(VkDevice, uint32_t, const VkFence*) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetFenceStatus(VkDevice, VkFence) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetEventStatus(VkDevice, VkEvent) {
+		return VK_EVENT_SET;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL SetEvent(VkDevice, VkEvent) {
+		return VK_SUCCESS;
+	}
+
+	// swap chain
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice, const VkSwapchainCreateInfoKHR* a_info,
+	                                                  const VkAllocationCallbacks*, VkSwapchainKHR* a_swapchain) {
+		*a_swapchain = NewHandle<VkSwapchainKHR>();
+		Swapchain swapchain;
+		for(uint32_t i = 0; i < a_info->minImageCount; ++i) { swapchain.Images.push_back(NewHandle<VkImage>()); }
+		scoped_lock lock(g_mutex);
+		g_swapchains.emplace(Key(*a_swapchain), move(swapchain));
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL DestroySwapchainKHR(VkDevice, VkSwapchainKHR a_swapchain,
+	                                               const VkAllocationCallbacks*) {
+		scoped_lock lock(g_mutex);
+		g_swapchains.erase(Key(a_swapchain));
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice, VkSwapchainKHR a_swapchain, uint32_t* a_count,
+	                                                     VkImage* a_images) {
+		scoped_lock lock(g_mutex);
+		const auto& images = g_swapchains.at(Key(a_swapchain)).Images;
+		return Enumerate(a_count, a_images, images.data(), (uint32_t)images.size());
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL AcquireNextImageKHR(VkDevice, VkSwapchainKHR a_swapchain, uint64_t, VkSemaphore,
+	                                                   VkFence, uint32_t* a_index) {
+		scoped_lock lock(g_mutex);
+		auto& swapchain     = g_swapchains.at(Key(a_swapchain));
+		*a_index            = swapchain.NextImage;
+		swapchain.NextImage = (swapchain.NextImage + 1) % (uint32_t)swapchain.Images.size();
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue, const VkPresentInfoKHR* a_info) {
+		if(a_info->pResults) { fill(a_info->pResults, a_info->pResults + a_info->swapchainCount, VK_SUCCESS); }
+		return VK_SUCCESS;
+	}
+
+	// memory, only host visible memory gets real memory behind it
+
+	VKAPI_ATTR VkResult VKAPI_CALL AllocateMemory(VkDevice, const VkMemoryAllocateInfo* a_info,
+	                                              const VkAllocationCallbacks*, VkDeviceMemory* a_memory) {
+		std::byte* data = nullptr;
+		if(a_info->memoryTypeIndex == c_hostVisible) {
+			data = (std::byte*)malloc(a_info->allocationSize);
+			if(!data) { return VK_ERROR_OUT_OF_HOST_MEMORY; }
+		}
+		*a_memory = NewHandle<VkDeviceMemory>();
+		scoped_lock lock(g_mutex);
+		g_memory.emplace(Key(*a_memory), data);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL FreeMemory(VkDevice, VkDeviceMemory a_memory, const VkAllocationCallbacks*) {
+		scoped_lock lock(g_mutex);
+		auto iter = g_memory.find(Key(a_memory));
+		if(iter == g_memory.end()) { return; }
+		free(iter->second);
+		g_memory.erase(iter);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL MapMemory(VkDevice, VkDeviceMemory a_memory, VkDeviceSize a_offset, VkDeviceSize,
+	                                         VkMemoryMapFlags, void** a_data) {
+		scoped_lock lock(g_mutex);
+		std::byte* data = g_memory.at(Key(a_memory));
+		if(!data) { return VK_ERROR_MEMORY_MAP_FAILED; }
+		*a_data = data + a_offset;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL UnmapMemory(VkDevice, VkDeviceMemory) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL BindBufferMemory(VkDevice, VkBuffer, VkDeviceMemory, VkDeviceSize) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL BindImageMemory(VkDevice, VkImage, VkDeviceMemory, VkDeviceSize) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateBuffer(VkDevice, const VkBufferCreateInfo* a_info,
+	                                            const VkAllocationCallbacks*, VkBuffer* a_buffer) {
+		*a_buffer = NewHandle<VkBuffer>();
+		scoped_lock lock(g_mutex);
+		g_resourceSizes.emplace(Key(*a_buffer), a_info->size);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateImage(VkDevice, const VkImageCreateInfo* a_info,
+	                                           const VkAllocationCallbacks*, VkImage* a_image) {
+		*a_image = NewHandle<VkImage>();
+		// only needs to be plausible, bc7 is a byte per texel, assume 4 for everything else.
+		VkDeviceSize texelSize = a_info->format == VK_FORMAT_BC7_SRGB_BLOCK ? 1 : 4;
+		VkDeviceSize size = (VkDeviceSize)a_info->extent.width * a_info->extent.height * a_info->extent.depth *
+		                    a_info->arrayLayers * a_info->samples * texelSize;
+		scoped_lock lock(g_mutex);
+		g_resourceSizes.emplace(Key(*a_image), size);
+		return VK_SUCCESS;
+	}
+
+	template<typename Handle>
+	VKAPI_ATTR void VKAPI_CALL DestroyResource(VkDevice, Handle a_resource, const VkAllocationCallbacks*) {
+		scoped_lock lock(g_mutex);
+		g_resourceSizes.erase(Key(a_resource));
+	}
+
+	void FillRequirements(uint64_t a_resource, VkMemoryRequirements* a_reqs) {
+		scoped_lock lock(g_mutex);
+		VkDeviceSize size      = g_resourceSizes.at(a_resource);
+		a_reqs->size           = std::max<VkDeviceSize>((size + c_alignment - 1) & ~(c_alignment - 1), c_alignment);
+		a_reqs->alignment      = c_alignment;
+		a_reqs->memoryTypeBits = (1u << c_deviceLocal) | (1u << c_hostVisible);
+	}
+
+	void FillRequirements2(uint64_t a_resource, VkMemoryRequirements2* a_reqs) {
+		FillRequirements(a_resource, &a_reqs->memoryRequirements);
+		for(auto* next = (VkBaseOutStructure*)a_reqs->pNext; next; next = next->pNext) {
+			if(next->sType == VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS) {
+				auto* dedicated                        = (VkMemoryDedicatedRequirements*)next;
+				dedicated->prefersDedicatedAllocation  = VK_FALSE;
+				dedicated->requiresDedicatedAllocation = VK_FALSE;
+			}
+		}
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetBufferMemoryRequirements(VkDevice, VkBuffer a_buffer,
+	                                                       VkMemoryRequirements* a_reqs) {
+		FillRequirements(Key(a_buffer), a_reqs);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetImageMemoryRequirements(VkDevice, VkImage a_image, VkMemoryRequirements* a_reqs) {
+		FillRequirements(Key(a_image), a_reqs);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetBufferMemoryRequirements2(VkDevice, const VkBufferMemoryRequirementsInfo2* a_info,
+	                                                        VkMemoryRequirements2* a_reqs) {
+		FillRequirements2(Key(a_info->buffer), a_reqs);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL GetImageMemoryRequirements2(VkDevice, const VkImageMemoryRequirementsInfo2* a_info,
+	                                                       VkMemoryRequirements2* a_reqs) {
+		FillRequirements2(Key(a_info->image), a_reqs);
+	}
+
+	// pools and pipelines
+
+	VKAPI_ATTR VkResult VKAPI_CALL ResetCommandPool(VkDevice, VkCommandPool, VkCommandPoolResetFlags) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL AllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* a_info,
+	                                                      VkCommandBuffer* a_buffers) {
+		generate(a_buffers, a_buffers + a_info->commandBufferCount, NewHandle<VkCommandBuffer>);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL FreeCommandBuffers(VkDevice, VkCommandPool, uint32_t, const VkCommandBuffer*) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL BeginCommandBuffer(VkCommandBuffer, const VkCommandBufferBeginInfo*) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL EndCommandBuffer(VkCommandBuffer) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL ResetCommandBuffer(VkCommandBuffer, VkCommandBufferResetFlags) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL ResetDescriptorPool(VkDevice, VkDescriptorPool, VkDescriptorPoolResetFlags) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL AllocateDescriptorSets(VkDevice, const VkDescriptorSetAllocateInfo* a_info,
+	                                                      VkDescriptorSet* a_sets) {
+		generate(a_sets, a_sets + a_info->descriptorSetCount, NewHandle<VkDescriptorSet>);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL FreeDescriptorSets(VkDevice, VkDescriptorPool, uint32_t, const VkDescriptorSet*) {
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL UpdateDescriptorSets(VkDevice, uint32_t, const VkWriteDescriptorSet*, uint32_t,
+	                                                const VkCopyDescriptorSet*) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CreateGraphicsPipelines(VkDevice, VkPipelineCache, uint32_t a_count,
+	                                                       const VkGraphicsPipelineCreateInfo*,
+	                                                       const VkAllocationCallbacks*, VkPipeline* a_pipelines) {
+		generate(a_pipelines, a_pipelines + a_count, NewHandle<VkPipeline>);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetPipelineCacheData(VkDevice, VkPipelineCache, size_t* a_size, void*) {
+		*a_size = 0;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL GetQueryPoolResults(VkDevice, VkQueryPool, uint32_t, uint32_t, size_t a_dataSize,
+	                                                   void* a_data, VkDeviceSize, VkQueryResultFlags) {
+		memset(a_data, 0, a_dataSize);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL ResetQueryPool(VkDevice, VkQueryPool, uint32_t, uint32_t) {}
+
+	// commands, only logged
+
+	VKAPI_ATTR void VKAPI_CALL CmdBeginRenderPass(VkCommandBuffer a_cmd, const VkRenderPassBeginInfo*,
+	                                              VkSubpassContents) {
+		LogCommand("vkCmdBeginRenderPass", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdEndRenderPass(VkCommandBuffer a_cmd) {
+		LogCommand("vkCmdEndRenderPass", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdBindDescriptorSets(VkCommandBuffer a_cmd, VkPipelineBindPoint, VkPipelineLayout,
+	                                                 uint32_t, uint32_t, const VkDescriptorSet*, uint32_t,
+	                                                 const uint32_t*) {
+		LogCommand("vkCmdBindDescriptorSets", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdBindPipeline(VkCommandBuffer a_cmd, VkPipelineBindPoint, VkPipeline) {
+		LogCommand("vkCmdBindPipeline", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdBindVertexBuffers(VkCommandBuffer a_cmd, uint32_t, uint32_t, const VkBuffer*,
+	                                                const VkDeviceSize*) {
+		LogCommand("vkCmdBindVertexBuffers", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdCopyBuffer(VkCommandBuffer a_cmd, VkBuffer, VkBuffer, uint32_t,
+	                                         const VkBufferCopy*) {
+		LogCommand("vkCmdCopyBuffer", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdCopyBufferToImage(VkCommandBuffer a_cmd, VkBuffer, VkImage, VkImageLayout,
+	                                                uint32_t, const VkBufferImageCopy*) {
+		LogCommand("vkCmdCopyBufferToImage", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdExecuteCommands(VkCommandBuffer a_cmd, uint32_t, const VkCommandBuffer*) {
+		LogCommand("vkCmdExecuteCommands", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdPipelineBarrier(VkCommandBuffer a_cmd, VkPipelineStageFlags, VkPipelineStageFlags,
+	                                              VkDependencyFlags, uint32_t, const VkMemoryBarrier*, uint32_t,
+	                                              const VkBufferMemoryBarrier*, uint32_t,
+	                                              const VkImageMemoryBarrier*) {
+		LogCommand("vkCmdPipelineBarrier", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdPushConstants(VkCommandBuffer a_cmd, VkPipelineLayout, VkShaderStageFlags,
+	                                            uint32_t, uint32_t, const void*) {
+		LogCommand("vkCmdPushConstants", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdSetScissor(VkCommandBuffer a_cmd, uint32_t, uint32_t, const VkRect2D*) {
+		LogCommand("vkCmdSetScissor", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdSetViewport(VkCommandBuffer a_cmd, uint32_t, uint32_t, const VkViewport*) {
+		LogCommand("vkCmdSetViewport", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdSetEvent(VkCommandBuffer a_cmd, VkEvent, VkPipelineStageFlags) {
+		LogCommand("vkCmdSetEvent", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdResetEvent(VkCommandBuffer a_cmd, VkEvent, VkPipelineStageFlags) {
+		LogCommand("vkCmdResetEvent", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdWaitEvents(VkCommandBuffer a_cmd, uint32_t, const VkEvent*, VkPipelineStageFlags,
+	                                         VkPipelineStageFlags, uint32_t, const VkMemoryBarrier*, uint32_t,
+	                                         const VkBufferMemoryBarrier*, uint32_t, const VkImageMemoryBarrier*) {
+		LogCommand("vkCmdWaitEvents", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdDraw(VkCommandBuffer a_cmd, uint32_t, uint32_t, uint32_t, uint32_t) {
+		LogCommand("vkCmdDraw", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdWriteTimestamp(VkCommandBuffer a_cmd, VkPipelineStageFlagBits, VkQueryPool,
+	                                             uint32_t) {
+		LogCommand("vkCmdWriteTimestamp", a_cmd);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CmdResetQueryPool(VkCommandBuffer a_cmd, VkQueryPool, uint32_t, uint32_t) {
+		LogCommand("vkCmdResetQueryPool", a_cmd);
+	}
+
+	VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL InstanceProcAddr(VkInstance, const char* a_name);
+	VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL DeviceProcAddr(VkDevice, const char* a_name);
+
+	struct Entry {
+		const char* Name;
+		PFN_vkVoidFunction Func;
+	};
+#define CR_NULL_ENTRY(name, func) Entry{name, (PFN_vkVoidFunction)(func)}
+	// Everything the engine calls. The dispatcher asks for every function it knows about, anything not in here is
+	// left null, and will crash if called. Add it here when the engine starts using something new.
+	const Entry c_entries[] = {
+	    CR_NULL_ENTRY("vkGetInstanceProcAddr", &InstanceProcAddr),
+	    CR_NULL_ENTRY("vkGetDeviceProcAddr", &DeviceProcAddr),
+	    CR_NULL_ENTRY("vkEnumerateInstanceVersion", &EnumerateInstanceVersion),
+	    CR_NULL_ENTRY("vkEnumerateInstanceLayerProperties", &EnumerateLayerProperties),
+	    CR_NULL_ENTRY("vkEnumerateInstanceExtensionProperties", &EnumerateInstanceExtensionProperties),
+	    CR_NULL_ENTRY("vkCreateInstance", &CreateInstance),
+	    CR_NULL_ENTRY("vkDestroyInstance", &DestroyInstance),
+	    CR_NULL_ENTRY("vkEnumeratePhysicalDevices", &EnumeratePhysicalDevices),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceProperties", &GetPhysicalDeviceProperties),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceFeatures", &GetPhysicalDeviceFeatures),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceMemoryProperties", &GetPhysicalDeviceMemoryProperties),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceQueueFamilyProperties", &GetPhysicalDeviceQueueFamilyProperties),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceSurfaceSupportKHR", &GetPhysicalDeviceSurfaceSupportKHR),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceSurfaceCapabilitiesKHR", &GetPhysicalDeviceSurfaceCapabilitiesKHR),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceSurfaceFormatsKHR", &GetPhysicalDeviceSurfaceFormatsKHR),
+	    CR_NULL_ENTRY("vkGetPhysicalDeviceSurfacePresentModesKHR", &GetPhysicalDeviceSurfacePresentModesKHR),
+	    CR_NULL_ENTRY("vkEnumerateDeviceLayerProperties", &EnumerateDeviceLayerProperties),
+	    CR_NULL_ENTRY("vkEnumerateDeviceExtensionProperties", &EnumerateDeviceExtensionProperties),
+	    CR_NULL_ENTRY("vkCreateWin32SurfaceKHR", &CreateWin32SurfaceKHR),
+	    CR_NULL_ENTRY("vkDestroySurfaceKHR", &DestroySurfaceKHR),
+	    CR_NULL_ENTRY("vkCreateDevice", &CreateDevice),
+	    CR_NULL_ENTRY("vkDestroyDevice", &DestroyDevice),
+	    CR_NULL_ENTRY("vkDeviceWaitIdle", &Success),
+	    CR_NULL_ENTRY("vkGetDeviceQueue", &GetDeviceQueue),
+	    CR_NULL_ENTRY("vkQueueSubmit", &QueueSubmit),
+	    CR_NULL_ENTRY("vkQueueWaitIdle", &QueueWaitIdle),
+	    CR_NULL_ENTRY("vkQueuePresentKHR", &QueuePresentKHR),
+	    CR_NULL_ENTRY("vkCreateSwapchainKHR", &CreateSwapchainKHR),
+	    CR_NULL_ENTRY("vkDestroySwapchainKHR", &DestroySwapchainKHR),
+	    CR_NULL_ENTRY("vkGetSwapchainImagesKHR", &GetSwapchainImagesKHR),
+	    CR_NULL_ENTRY("vkAcquireNextImageKHR", &AcquireNextImageKHR),
+	    CR_NULL_ENTRY("vkCreateFence", (&Create<VkFenceCreateInfo, VkFence>)),
+	    CR_NULL_ENTRY("vkDestroyFence", &Destroy<VkFence>),
+	    CR_NULL_ENTRY("vkWaitForFences", &WaitForFences),
+	    CR_NULL_ENTRY("vkResetFences", &ResetFences),
+	    CR_NULL_ENTRY("vkGetFenceStatus", &GetFenceStatus),
+	    CR_NULL_ENTRY("vkCreateSemaphore", (&Create<VkSemaphoreCreateInfo, VkSemaphore>)),
+	    CR_NULL_ENTRY("vkDestroySemaphore", &Destroy<VkSemaphore>),
+	    CR_NULL_ENTRY("vkCreateEvent", (&Create<VkEventCreateInfo, VkEvent>)),
+	    CR_NULL_ENTRY("vkDestroyEvent", &Destroy<VkEvent>),
+	    CR_NULL_ENTRY("vkGetEventStatus", &GetEventStatus),
+	    CR_NULL_ENTRY("vkSetEvent", &SetEvent),
+	    CR_NULL_ENTRY("vkResetEvent", &SetEvent),
+	    CR_NULL_ENTRY("vkAllocateMemory", &AllocateMemory),
+	    CR_NULL_ENTRY("vkFreeMemory", &FreeMemory),
+	    CR_NULL_ENTRY("vkMapMemory", &MapMemory),
+	    CR_NULL_ENTRY("vkUnmapMemory", &UnmapMemory),
+	    CR_NULL_ENTRY("vkBindBufferMemory", &BindBufferMemory),
+	    CR_NULL_ENTRY("vkBindImageMemory", &BindImageMemory),
+	    CR_NULL_ENTRY("vkCreateBuffer", &CreateBuffer),
+	    CR_NULL_ENTRY("vkDestroyBuffer", &DestroyResource<VkBuffer>),
+	    CR_NULL_ENTRY("vkCreateImage", &CreateImage),
+	    CR_NULL_ENTRY("vkDestroyImage", &DestroyResource<VkImage>),
+	    CR_NULL_ENTRY("vkGetBufferMemoryRequirements", &GetBufferMemoryRequirements),
+	    CR_NULL_ENTRY("vkGetImageMemoryRequirements", &GetImageMemoryRequirements),
+	    CR_NULL_ENTRY("vkGetBufferMemoryRequirements2", &GetBufferMemoryRequirements2),
+	    CR_NULL_ENTRY("vkGetBufferMemoryRequirements2KHR", &GetBufferMemoryRequirements2),
+	    CR_NULL_ENTRY("vkGetImageMemoryRequirements2", &GetImageMemoryRequirements2),
+	    CR_NULL_ENTRY("vkGetImageMemoryRequirements2KHR", &GetImageMemoryRequirements2),
+	    CR_NULL_ENTRY("vkCreateImageView", (&Create<VkImageViewCreateInfo, VkImageView>)),
+	    CR_NULL_ENTRY("vkDestroyImageView", &Destroy<VkImageView>),
+	    CR_NULL_ENTRY("vkCreateFramebuffer", (&Create<VkFramebufferCreateInfo, VkFramebuffer>)),
+	    CR_NULL_ENTRY("vkDestroyFramebuffer", &Destroy<VkFramebuffer>),
+	    CR_NULL_ENTRY("vkCreateRenderPass", (&Create<VkRenderPassCreateInfo, VkRenderPass>)),
+	    CR_NULL_ENTRY("vkDestroyRenderPass", &Destroy<VkRenderPass>),
+	    CR_NULL_ENTRY("vkCreateSampler", (&Create<VkSamplerCreateInfo, VkSampler>)),
+	    CR_NULL_ENTRY("vkDestroySampler", &Destroy<VkSampler>),
+	    CR_NULL_ENTRY("vkCreateShaderModule", (&Create<VkShaderModuleCreateInfo, VkShaderModule>)),
+	    CR_NULL_ENTRY("vkDestroyShaderModule", &Destroy<VkShaderModule>),
+	    CR_NULL_ENTRY("vkCreatePipelineLayout", (&Create<VkPipelineLayoutCreateInfo, VkPipelineLayout>)),
+	    CR_NULL_ENTRY("vkDestroyPipelineLayout", &Destroy<VkPipelineLayout>),
+	    CR_NULL_ENTRY("vkCreatePipelineCache", (&Create<VkPipelineCacheCreateInfo, VkPipelineCache>)),
+	    CR_NULL_ENTRY("vkDestroyPipelineCache", &Destroy<VkPipelineCache>),
+	    CR_NULL_ENTRY("vkGetPipelineCacheData", &GetPipelineCacheData),
+	    CR_NULL_ENTRY("vkCreateGraphicsPipelines", &CreateGraphicsPipelines),
+	    CR_NULL_ENTRY("vkDestroyPipeline", &Destroy<VkPipeline>),
+	    CR_NULL_ENTRY("vkCreateDescriptorSetLayout",
+	                  (&Create<VkDescriptorSetLayoutCreateInfo, VkDescriptorSetLayout>)),
+	    CR_NULL_ENTRY("vkDestroyDescriptorSetLayout", &Destroy<VkDescriptorSetLayout>),
+	    CR_NULL_ENTRY("vkCreateDescriptorPool", (&Create<VkDescriptorPoolCreateInfo, VkDescriptorPool>)),
+	    CR_NULL_ENTRY("vkDestroyDescriptorPool", &Destroy<VkDescriptorPool>),
+	    CR_NULL_ENTRY("vkResetDescriptorPool", &ResetDescriptorPool),
+	    CR_NULL_ENTRY("vkAllocateDescriptorSets", &AllocateDescriptorSets),
+	    CR_NULL_ENTRY("vkFreeDescriptorSets", &FreeDescriptorSets),
+	    CR_NULL_ENTRY("vkUpdateDescriptorSets", &UpdateDescriptorSets),
+	    CR_NULL_ENTRY("vkCreateQueryPool", (&Create<VkQueryPoolCreateInfo, VkQueryPool>)),
+	    CR_NULL_ENTRY("vkDestroyQueryPool", &Destroy<VkQueryPool>),
+	    CR_NULL_ENTRY("vkGetQueryPoolResults", &GetQueryPoolResults),
+	    CR_NULL_ENTRY("vkResetQueryPool", &ResetQueryPool),
+	    CR_NULL_ENTRY("vkCreateCommandPool", (&Create<VkCommandPoolCreateInfo, VkCommandPool>)),
+	    CR_NULL_ENTRY("vkDestroyCommandPool", &Destroy<VkCommandPool>),
+	    CR_NULL_ENTRY("vkResetCommandPool", &ResetCommandPool),
+	    CR_NULL_ENTRY("vkAllocateCommandBuffers", &AllocateCommandBuffers),
+	    CR_NULL_ENTRY("vkFreeCommandBuffers", &FreeCommandBuffers),
+	    CR_NULL_ENTRY("vkBeginCommandBuffer", &BeginCommandBuffer),
+	    CR_NULL_ENTRY("vkEndCommandBuffer", &EndCommandBuffer),
+	    CR_NULL_ENTRY("vkResetCommandBuffer", &ResetCommandBuffer),
+	    CR_NULL_ENTRY("vkCmdBeginRenderPass", &CmdBeginRenderPass),
+	    CR_NULL_ENTRY("vkCmdEndRenderPass", &CmdEndRenderPass),
+	    CR_NULL_ENTRY("vkCmdBindDescriptorSets", &CmdBindDescriptorSets),
+	    CR_NULL_ENTRY("vkCmdBindPipeline", &CmdBindPipeline),
+	    CR_NULL_ENTRY("vkCmdBindVertexBuffers", &CmdBindVertexBuffers),
+	    CR_NULL_ENTRY("vkCmdCopyBuffer", &CmdCopyBuffer),
+	    CR_NULL_ENTRY("vkCmdCopyBufferToImage", &CmdCopyBufferToImage),
+	    CR_NULL_ENTRY("vkCmdExecuteCommands", &CmdExecuteCommands),
+	    CR_NULL_ENTRY("vkCmdPipelineBarrier", &CmdPipelineBarrier),
+	    CR_NULL_ENTRY("vkCmdPushConstants", &CmdPushConstants),
+	    CR_NULL_ENTRY("vkCmdSetScissor", &CmdSetScissor),
+	    CR_NULL_ENTRY("vkCmdSetViewport", &CmdSetViewport),
+	    CR_NULL_ENTRY("vkCmdSetEvent", &CmdSetEvent),
+	    CR_NULL_ENTRY("vkCmdResetEvent", &CmdResetEvent),
+	    CR_NULL_ENTRY("vkCmdWaitEvents", &CmdWaitEvents),
+	    CR_NULL_ENTRY("vkCmdDraw", &CmdDraw),
+	    CR_NULL_ENTRY("vkCmdWriteTimestamp", &CmdWriteTimestamp),
+	    CR_NULL_ENTRY("vkCmdResetQueryPool", &CmdResetQueryPool),
+	};
+#undef CR_NULL_ENTRY
+
+	VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL InstanceProcAddr(VkInstance, const char* a_name) {
+		for(const auto& entry : c_entries) {
+			if(strcmp(entry.Name, a_name) == 0) { return entry.Func; }
+		}
+		return nullptr;
+	}
+
+	VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL DeviceProcAddr(VkDevice, const char* a_name) {
+		return InstanceProcAddr(VkInstance{}, a_name);
+	}
+}    // namespace
+
+PFN_vkGetInstanceProcAddr NullDevice::GetInstanceProcAddr() {
+	return &InstanceProcAddr;
+}
+
+vector<NullDevice::Command> NullDevice::TakeCommandLog() {
+	scoped_lock lock(g_mutex);
+	vector<Command> result;
+	result.swap(g_commandLog);
+	return result;
+}
@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include "VulkanWindows.h"
+
+#include <cstdint>
+#include <vector>
+
+// Stands in for a vulkan driver, for running the cpu side of the engine on machines without a gpu, or any vulkan
+// driver at all. Used when EngineSettings::NullBackend is set. Every vulkan call the engine makes goes through the
+// default dispatcher, which is pointed at these stubs instead of the loader. Resource creation just hands out unique
+// handles, host visible memory is backed by plain heap memory, the gpu is always idle, and commands are only recorded
+// into a log. Reports a single device with a graphics+present queue family, and a dedicated transfer family.
+namespace CR::Graphics::NullDevice {
+	inline constexpr uint32_t c_maxLoggedCommands = 65536;
+	// What the surface reports as its size, there is no window behind it.
+	inline constexpr vk::Extent2D c_surfaceExtent{1280, 720};
+
+	// Hand to the dispatcher in place of the loader's vkGetInstanceProcAddr.
+	[[nodiscard]] PFN_vkGetInstanceProcAddr GetInstanceProcAddr();
+
+	struct Command {
+		const char* Name{nullptr};    // vulkan function, i.e. vkCmdDraw
+		vk::CommandBuffer CommandBuffer;
+	};
+	// Commands recorded since the last call, in recording order. Anything past c_maxLoggedCommands is dropped.
+	[[nodiscard]] std::vector<Command> TakeCommandLog();
+}    // namespace CR::Graphics::NullDevice
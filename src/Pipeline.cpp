@@ -2,7 +2,11 @@
 
 #include "Constants.h"
 #include "EngineInternal.h"
+#include "HostAllocator.h"
+#include "PipelineCache.h"
+#include "PipelineCompileThread.h"
 #include "TextureSets.h"
+#include "Trace.h"
 
 #include "DataCompression/LosslessCompression.h"
 #include "core/BinaryStream.h"
@@ -12,7 +16,57 @@ using namespace std;
 using namespace CR;
 using namespace CR::Graphics;
 
-Pipeline::Pipeline(const CreatePipelineArgs& a_args) {
+namespace {
+	vk::PipelineColorBlendAttachmentState GetBlendState(BlendMode a_blend) {
+		vk::PipelineColorBlendAttachmentState result;
+		result.blendEnable         = a_blend != BlendMode::None;
+		result.colorBlendOp        = vk::BlendOp::eAdd;
+		result.alphaBlendOp        = vk::BlendOp::eAdd;
+		result.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+		result.dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		result.colorWriteMask      = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+		                             vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+		switch(a_blend) {
+			case BlendMode::Alpha:
+				result.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+				result.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+				break;
+			case BlendMode::PremultipliedAlpha:
+				result.srcColorBlendFactor = vk::BlendFactor::eOne;
+				result.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+				break;
+			case BlendMode::Additive:
+				result.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+				result.dstColorBlendFactor = vk::BlendFactor::eOne;
+				result.srcAlphaBlendFactor = vk::BlendFactor::eZero;
+				result.dstAlphaBlendFactor = vk::BlendFactor::eOne;
+				break;
+			default:
+				break;
+		}
+		return result;
+	}
+}    // namespace
+
+// Everything the compile thread needs, captured on the calling thread. After that only the compile thread touches it
+// until every variant has finished compiling.
+struct Pipeline::CompileState {
+	Core::Span<const std::byte> ShaderModule;
+	vk::VertexInputBindingDescription BindingDesc;
+	std::vector<vk::VertexInputAttributeDescription> AttribDescription;
+	vk::PipelineLayout Layout;
+	vk::RenderPass RenderPass;
+
+	// Created by the first variant compiled, kept for the rest.
+	vk::ShaderModule VertModule;
+	vk::ShaderModule FragModule;
+	vk::Pipeline BasePipeline;
+
+	vk::Pipeline Compile(const PipelineVariant& a_variant);
+	void LoadShaders();
+};
+
+void Pipeline::CompileState::LoadShaders() {
 	auto& device = GetDevice();
 #pragma pack(1)
 	static const uint32_t c_FourCC  = 'CRSM';
@@ -26,9 +80,9 @@ Pipeline::Pipeline(const CreatePipelineArgs& a_args) {
 #pragma pack()
 	Header header;
 	Core::BinaryReader reader;
-	reader.Data   = a_args.ShaderModule.data();
+	reader.Data   = ShaderModule.data();
 	reader.Offset = 0;
-	reader.Size   = (uint32_t)a_args.ShaderModule.size();
+	reader.Size   = (uint32_t)ShaderModule.size();
 
 	Core::Read(reader, header);
 	Core::Log::Require(header.FourCC == c_FourCC, "Shader is not a crsm file");
@@ -54,42 +108,38 @@ Pipeline::Pipeline(const CreatePipelineArgs& a_args) {
 	fragInfo.pCode    = (uint32_t*)fragShader.data();
 	fragInfo.codeSize = fragShader.size();
 
-	vk::UniqueShaderModule vertModule = device.createShaderModuleUnique(vertInfo);
-	vk::UniqueShaderModule fragModule = device.createShaderModuleUnique(fragInfo);
-
-	std::vector<std::byte> specVertBuffer;
-
-	vk::SpecializationMapEntry vertSpecInfoEntrys[2];
-	vertSpecInfoEntrys[0].constantID = 0;
-	vertSpecInfoEntrys[0].offset     = (uint32_t)Core::Write(specVertBuffer, 1.0f / GetWindowSize().x);
-	vertSpecInfoEntrys[0].size       = sizeof(float);
-	vertSpecInfoEntrys[1].constantID = 1;
-	vertSpecInfoEntrys[1].offset     = (uint32_t)Core::Write(specVertBuffer, 1.0f / GetWindowSize().y);
-	vertSpecInfoEntrys[1].size       = sizeof(float);
-
-	vk::SpecializationInfo vertSpecInfo;
-	vertSpecInfo.dataSize      = specVertBuffer.size();
-	vertSpecInfo.pData         = specVertBuffer.data();
-	vertSpecInfo.mapEntryCount = (uint32_t)size(vertSpecInfoEntrys);
-	vertSpecInfo.pMapEntries   = data(vertSpecInfoEntrys);
+	VertModule = device.createShaderModule(vertInfo, HostAllocator::Get());
+	FragModule = device.createShaderModule(fragInfo, HostAllocator::Get());
+}
 
-	vk::SpecializationMapEntry fragSpecInfoEntrys;
-	fragSpecInfoEntrys.constantID = 0;
-	fragSpecInfoEntrys.offset     = 0;
-	fragSpecInfoEntrys.size       = sizeof(int32_t);
+vk::Pipeline Pipeline::CompileState::Compile(const PipelineVariant& a_variant) {
+	auto& device = GetDevice();
+	if(!VertModule) { LoadShaders(); }
+
+	std::vector<std::byte> specFragBuffer;
+
+	vk::SpecializationMapEntry fragSpecInfoEntrys[PipelineVariant::c_maxSpecConstants + 1];
+	fragSpecInfoEntrys[0].constantID = 0;
+	fragSpecInfoEntrys[0].offset     = (uint32_t)Core::Write(specFragBuffer, c_maxTextures);
+	fragSpecInfoEntrys[0].size       = sizeof(int32_t);
+	for(uint32_t i = 0; i < PipelineVariant::c_maxSpecConstants; ++i) {
+		fragSpecInfoEntrys[i + 1].constantID = i + 1;
+		fragSpecInfoEntrys[i + 1].offset     = (uint32_t)Core::Write(specFragBuffer, a_variant.SpecConstants[i]);
+		fragSpecInfoEntrys[i + 1].size       = sizeof(int32_t);
+	}
 
 	vk::SpecializationInfo fragSpecInfo;
-	fragSpecInfo.dataSize      = sizeof(c_maxTextures);
-	fragSpecInfo.pData         = &c_maxTextures;
-	fragSpecInfo.mapEntryCount = 1;
-	fragSpecInfo.pMapEntries   = &fragSpecInfoEntrys;
+	fragSpecInfo.dataSize      = specFragBuffer.size();
+	fragSpecInfo.pData         = specFragBuffer.data();
+	fragSpecInfo.mapEntryCount = (uint32_t)size(fragSpecInfoEntrys);
+	fragSpecInfo.pMapEntries   = data(fragSpecInfoEntrys);
 
 	vk::PipelineShaderStageCreateInfo shaderPipeInfo[2];
-	shaderPipeInfo[0].module              = vertModule.get();
+	shaderPipeInfo[0].module              = VertModule;
 	shaderPipeInfo[0].pName               = "main";
 	shaderPipeInfo[0].stage               = vk::ShaderStageFlagBits::eVertex;
-	shaderPipeInfo[0].pSpecializationInfo = &vertSpecInfo;
-	shaderPipeInfo[1].module              = fragModule.get();
+	shaderPipeInfo[0].pSpecializationInfo = nullptr;
+	shaderPipeInfo[1].module              = FragModule;
 	shaderPipeInfo[1].pName               = "main";
 	shaderPipeInfo[1].stage               = vk::ShaderStageFlagBits::eFragment;
 	shaderPipeInfo[1].pSpecializationInfo = &fragSpecInfo;
@@ -97,48 +147,74 @@ Pipeline::Pipeline(const CreatePipelineArgs& a_args) {
 	// defaults are fine for this one. we dont have a vertex buffer
 	vk::PipelineVertexInputStateCreateInfo vertInputInfo;
 	vertInputInfo.vertexBindingDescriptionCount   = 1;
-	vertInputInfo.pVertexBindingDescriptions      = &a_args.BindingDesc;
-	vertInputInfo.vertexAttributeDescriptionCount = (uint32_t)a_args.AttribDescription.size();
-	vertInputInfo.pVertexAttributeDescriptions    = a_args.AttribDescription.data();
+	vertInputInfo.pVertexBindingDescriptions      = &BindingDesc;
+	vertInputInfo.vertexAttributeDescriptionCount = (uint32_t)AttribDescription.size();
+	vertInputInfo.pVertexAttributeDescriptions    = AttribDescription.data();
 	vk::PipelineInputAssemblyStateCreateInfo vertAssemblyInfo;
 	vertAssemblyInfo.topology = vk::PrimitiveTopology::eTriangleStrip;
 
-	vk::Viewport viewPort;
-	viewPort.width    = (float)GetWindowSize().x;
-	viewPort.height   = (float)GetWindowSize().y;
-	viewPort.minDepth = 0.0f;
-	viewPort.maxDepth = 1.0f;
-
-	vk::Rect2D scissor;
-	scissor.extent.width  = GetWindowSize().x;
-	scissor.extent.height = GetWindowSize().y;
-
+	// Viewport and scissor are set when the render pass begins, so a window resize doesn't need new pipelines.
 	vk::PipelineViewportStateCreateInfo viewPortInfo;
-	viewPortInfo.pViewports    = &viewPort;
+	viewPortInfo.pViewports    = nullptr;
 	viewPortInfo.viewportCount = 1;
-	viewPortInfo.pScissors     = &scissor;
+	viewPortInfo.pScissors     = nullptr;
 	viewPortInfo.scissorCount  = 1;
 
+	const vk::DynamicState dynamicStates[] = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+	vk::PipelineDynamicStateCreateInfo dynamicInfo;
+	dynamicInfo.dynamicStateCount = (uint32_t)size(dynamicStates);
+	dynamicInfo.pDynamicStates    = data(dynamicStates);
+
 	vk::PipelineRasterizationStateCreateInfo rasterInfo;
 	rasterInfo.cullMode         = vk::CullModeFlagBits::eNone;
 	rasterInfo.lineWidth        = 1.0f;
 	rasterInfo.depthClampEnable = false;
 
+	// nothing to cover with a single sample, it would only turn alpha into a hard cutoff.
+	bool alphaToCoverage = a_variant.AlphaToCoverage && a_variant.Samples != vk::SampleCountFlagBits::e1;
+
 	vk::PipelineMultisampleStateCreateInfo multisampleInfo;
-	multisampleInfo.alphaToCoverageEnable = true;
-	multisampleInfo.rasterizationSamples  = vk::SampleCountFlagBits::e4;
-	multisampleInfo.sampleShadingEnable   = true;
-	multisampleInfo.minSampleShading      = 1.0f;
+	multisampleInfo.alphaToCoverageEnable = alphaToCoverage;
+	multisampleInfo.rasterizationSamples  = a_variant.Samples;
+	multisampleInfo.sampleShadingEnable   = a_variant.MinSampleShading > 0.0f;
+	multisampleInfo.minSampleShading      = a_variant.MinSampleShading;
 
-	vk::PipelineColorBlendAttachmentState blendAttachState;
-	blendAttachState.blendEnable    = false;
-	blendAttachState.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
-	                                  vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+	vk::PipelineColorBlendAttachmentState blendAttachState = GetBlendState(a_variant.Blend);
 
 	vk::PipelineColorBlendStateCreateInfo blendStateInfo;
 	blendStateInfo.pAttachments    = &blendAttachState;
 	blendStateInfo.attachmentCount = 1;
 
+	vk::GraphicsPipelineCreateInfo pipeInfo;
+	pipeInfo.layout              = Layout;
+	pipeInfo.pColorBlendState    = &blendStateInfo;
+	pipeInfo.pInputAssemblyState = &vertAssemblyInfo;
+	pipeInfo.pMultisampleState   = &multisampleInfo;
+	pipeInfo.pRasterizationState = &rasterInfo;
+	pipeInfo.pVertexInputState   = &vertInputInfo;
+	pipeInfo.pViewportState      = &viewPortInfo;
+	pipeInfo.pDynamicState       = &dynamicInfo;
+	pipeInfo.stageCount          = 2;
+	pipeInfo.pStages             = shaderPipeInfo;
+	pipeInfo.renderPass          = RenderPass;
+
+	// First variant compiled is the parent of all the others, they tend to differ only a little.
+	if(BasePipeline) {
+		pipeInfo.flags              = vk::PipelineCreateFlagBits::eDerivative;
+		pipeInfo.basePipelineHandle = BasePipeline;
+		pipeInfo.basePipelineIndex  = -1;
+	} else {
+		pipeInfo.flags = vk::PipelineCreateFlagBits::eAllowDerivatives;
+	}
+
+	vk::Pipeline result = device.createGraphicsPipeline(PipelineCache::Get(), pipeInfo, HostAllocator::Get());
+	if(!BasePipeline) { BasePipeline = result; }
+	return result;
+}
+
+Pipeline::Pipeline(const CreatePipelineArgs& a_args) {
+	auto& device = GetDevice();
+
 	vk::SamplerCreateInfo samplerInfo;
 	samplerInfo.addressModeU     = vk::SamplerAddressMode::eClampToEdge;
 	samplerInfo.addressModeV     = vk::SamplerAddressMode::eClampToEdge;
@@ -148,7 +224,7 @@ Pipeline::Pipeline(const CreatePipelineArgs& a_args) {
 	samplerInfo.mipmapMode       = vk::SamplerMipmapMode::eNearest;
 	samplerInfo.anisotropyEnable = false;
 
-	m_sampler = GetDevice().createSampler(samplerInfo);
+	m_sampler = GetDevice().createSampler(samplerInfo, HostAllocator::Get());
 
 	// Have to pass one sampler per descriptor. but only using one sampler, so just have to duplicate
 	vector<vk::Sampler> samplers;
@@ -162,33 +238,48 @@ Pipeline::Pipeline(const CreatePipelineArgs& a_args) {
 	dslBinding[0].stageFlags         = vk::ShaderStageFlagBits::eFragment;
 	dslBinding[0].pImmutableSamplers = samplers.data();
 
+	// Textures stream in and out while the set is in use. Only the slots that changed get written, and slots that
+	// aren't in use yet are allowed to be empty.
+	vk::DescriptorBindingFlags dslBindingFlags[1];
+	dslBindingFlags[0] = vk::DescriptorBindingFlagBits::ePartiallyBound |
+	                     vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+	                     vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+
+	vk::DescriptorSetLayoutBindingFlagsCreateInfo dslFlagsInfo;
+	dslFlagsInfo.bindingCount  = (uint32_t)size(dslBindingFlags);
+	dslFlagsInfo.pBindingFlags = dslBindingFlags;
+
 	vk::DescriptorSetLayoutCreateInfo dslInfo;
 	dslInfo.bindingCount = (uint32_t)size(dslBinding);
 	dslInfo.pBindings    = dslBinding;
+	dslInfo.flags        = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+	dslInfo.pNext        = &dslFlagsInfo;
+
+	m_descriptorSetLayout = device.createDescriptorSetLayout(dslInfo, HostAllocator::Get());
 
-	m_descriptorSetLayout = device.createDescriptorSetLayout(dslInfo);
+	// InvScreenSize, changes with the window size.
+	vk::PushConstantRange pushRange;
+	pushRange.stageFlags = vk::ShaderStageFlagBits::eVertex;
+	pushRange.offset     = 0;
+	pushRange.size       = sizeof(glm::vec2);
 
 	vk::PipelineLayoutCreateInfo layoutInfo;
-	layoutInfo.pushConstantRangeCount = 0;
-	layoutInfo.pPushConstantRanges    = nullptr;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges    = &pushRange;
 	layoutInfo.setLayoutCount         = 1;
 	layoutInfo.pSetLayouts            = &m_descriptorSetLayout;
 
-	m_pipeLineLayout = device.createPipelineLayout(layoutInfo);
+	m_pipeLineLayout = device.createPipelineLayout(layoutInfo, HostAllocator::Get());
 
-	vk::GraphicsPipelineCreateInfo pipeInfo;
-	pipeInfo.layout              = m_pipeLineLayout;
-	pipeInfo.pColorBlendState    = &blendStateInfo;
-	pipeInfo.pInputAssemblyState = &vertAssemblyInfo;
-	pipeInfo.pMultisampleState   = &multisampleInfo;
-	pipeInfo.pRasterizationState = &rasterInfo;
-	pipeInfo.pVertexInputState   = &vertInputInfo;
-	pipeInfo.pViewportState      = &viewPortInfo;
-	pipeInfo.stageCount          = 2;
-	pipeInfo.pStages             = shaderPipeInfo;
-	pipeInfo.renderPass          = GetRenderPass();
+	m_compileState                    = make_shared<CompileState>();
+	m_compileState->ShaderModule      = a_args.ShaderModule;
+	m_compileState->BindingDesc       = a_args.BindingDesc;
+	m_compileState->AttribDescription = a_args.AttribDescription;
+	m_compileState->Layout            = m_pipeLineLayout;
+	m_compileState->RenderPass        = GetRenderPass();
 
-	m_pipeline = device.createGraphicsPipeline(vk::PipelineCache{}, pipeInfo);
+	m_defaultVariant = a_args.DefaultVariant;
+	RequestVariant(m_defaultVariant);
 }
 
 Pipeline::Pipeline(Pipeline&& a_other) noexcept {
@@ -198,15 +289,18 @@ Pipeline::Pipeline(Pipeline&& a_other) noexcept {
 Pipeline& Pipeline::operator=(Pipeline&& a_other) noexcept {
 	Free();
 
-	m_pipeline            = a_other.m_pipeline;
 	m_pipeLineLayout      = a_other.m_pipeLineLayout;
 	m_descriptorSetLayout = a_other.m_descriptorSetLayout;
 	m_sampler             = a_other.m_sampler;
+	m_defaultVariant      = a_other.m_defaultVariant;
+	m_variants            = move(a_other.m_variants);
+	m_compileState        = move(a_other.m_compileState);
+	m_lastTextureVersion  = a_other.m_lastTextureVersion;
 
-	a_other.m_pipeline            = vk::Pipeline{};
 	a_other.m_pipeLineLayout      = vk::PipelineLayout{};
 	a_other.m_descriptorSetLayout = vk::DescriptorSetLayout{};
 	a_other.m_sampler             = vk::Sampler{};
+	a_other.m_variants.clear();
 
 	return *this;
 }
@@ -215,31 +309,71 @@ Pipeline::~Pipeline() {
 	Free();
 }
 
+Pipeline::Variant& Pipeline::RequestVariant(const PipelineVariant& a_variant) {
+	auto iter = m_variants.find(a_variant);
+	if(iter == m_variants.end()) {
+		Variant variant;
+		// compile state is shared, so it stays alive until the compile thread is done, even if the pipeline moves.
+		variant.Pending = PipelineCompileThread::Compile(
+		    [state = m_compileState, a_variant]() { return state->Compile(a_variant); });
+		iter = m_variants.emplace(a_variant, move(variant)).first;
+	}
+	return iter.value();
+}
+
+bool Pipeline::IsReady(const PipelineVariant& a_variant) {
+	Variant& variant = RequestVariant(a_variant);
+	if(!variant.Handle && variant.Pending.valid() &&
+	   variant.Pending.wait_for(chrono::seconds(0)) == future_status::ready) {
+		variant.Handle = variant.Pending.get();
+	}
+	return (bool)variant.Handle;
+}
+
+const vk::Pipeline& Pipeline::GetHandle(const PipelineVariant& a_variant) const {
+	auto iter = m_variants.find(a_variant);
+	Core::Log::Assert(iter != m_variants.end() && iter->second.Handle, "Pipeline variant isn't ready yet");
+	return iter->second.Handle;
+}
+
 void Pipeline::Free() {
-	if(m_pipeline) {
-		ExecuteNextFrame([pipeline = m_pipeline, pipeLineLayout = m_pipeLineLayout,
-		                  descriptorSetLayout = m_descriptorSetLayout, sampler = m_sampler]() {
+	if(m_pipeLineLayout) {
+		// can't destroy anything out from under the compile thread, have to wait for it to finish.
+		vector<vk::Pipeline> pipelines;
+		for(auto iter = m_variants.begin(); iter != m_variants.end(); ++iter) {
+			Variant& variant = iter.value();
+			if(variant.Pending.valid()) { variant.Handle = variant.Pending.get(); }
+			pipelines.push_back(variant.Handle);
+		}
+
+		ExecuteNextFrame([pipelines = move(pipelines), pipeLineLayout = m_pipeLineLayout,
+		                  descriptorSetLayout = m_descriptorSetLayout, sampler = m_sampler,
+		                  vertModule = m_compileState->VertModule, fragModule = m_compileState->FragModule]() {
 			auto& device = GetDevice();
-			device.destroyPipeline(pipeline);
-			device.destroyPipelineLayout(pipeLineLayout);
-			device.destroyDescriptorSetLayout(descriptorSetLayout);
-			device.destroySampler(sampler);
+			for(auto& pipeline : pipelines) { device.destroyPipeline(pipeline, HostAllocator::Get()); }
+			device.destroyShaderModule(vertModule, HostAllocator::Get());
+			device.destroyShaderModule(fragModule, HostAllocator::Get());
+			device.destroyPipelineLayout(pipeLineLayout, HostAllocator::Get());
+			device.destroyDescriptorSetLayout(descriptorSetLayout, HostAllocator::Get());
+			device.destroySampler(sampler, HostAllocator::Get());
 		});
 	}
-	m_pipeline            = vk::Pipeline{};
 	m_pipeLineLayout      = vk::PipelineLayout{};
 	m_descriptorSetLayout = vk::DescriptorSetLayout{};
 	m_sampler             = vk::Sampler{};
+	m_variants.clear();
+	m_compileState.reset();
 }
 
-void Pipeline::Frame(vk::DescriptorSet& a_set) {
+bool Pipeline::Frame(vk::DescriptorSet& a_set) {
 	uint32_t currentVersion = TextureSets::GetCurrentVersion();
-	if(currentVersion > m_lastTextureVersion) {
-		std::vector<vk::ImageView> images;
-		std::vector<uint16_t> imageIndices;
-		TextureSets::GetImageData(images, imageIndices);
-		UpdateDescriptorSet(a_set, m_sampler, {images.data(), images.size()},
-		                    {imageIndices.data(), imageIndices.size()});
-		m_lastTextureVersion = currentVersion;
-	}
+	if(currentVersion <= m_lastTextureVersion) { return false; }
+
+	CR_TRACE_SCOPE("UpdateDescriptors");
+	std::vector<vk::ImageView> images;
+	std::vector<uint16_t> imageIndices;
+	TextureSets::GetImageDataSince(m_lastTextureVersion, images, imageIndices);
+	UpdateDescriptorSet(a_set, m_sampler, {images.data(), images.size()}, {imageIndices.data(), imageIndices.size()});
+	m_lastTextureVersion = currentVersion;
+	return true;
 }
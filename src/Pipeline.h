@@ -4,17 +4,69 @@
 #include "VulkanWindows.h"
 #include "core/Span.h"
 
+#include <3rdParty/robinmap.h>
+
+#include <array>
 #include <cstddef>
+#include <future>
 #include <memory>
 #include <vector>
 
+namespace CR::Graphics {
+	enum class BlendMode : uint8_t { None, Alpha, PremultipliedAlpha, Additive };
+
+	// Fixed function state and fragment specialization constants that can differ between pipelines built from the
+	// same shader. Pick the cheapest variant that looks right, i.e. per sample shading is expensive.
+	struct PipelineVariant {
+		inline static constexpr uint32_t c_maxSpecConstants = 4;
+
+		BlendMode Blend{BlendMode::None};
+		// Must match the render pass it is drawn in.
+		vk::SampleCountFlagBits Samples{vk::SampleCountFlagBits::e4};
+		// 0 disables sample shading.
+		float MinSampleShading{1.0f};
+		// Ignored with a single sample.
+		bool AlphaToCoverage{true};
+		// fragment shader constant ids 1 to c_maxSpecConstants, constant id 0 is always the max texture count.
+		std::array<int32_t, c_maxSpecConstants> SpecConstants{};
+
+		bool operator==(const PipelineVariant& a_other) const {
+			return Blend == a_other.Blend && Samples == a_other.Samples &&
+			       MinSampleShading == a_other.MinSampleShading && AlphaToCoverage == a_other.AlphaToCoverage &&
+			       SpecConstants == a_other.SpecConstants;
+		}
+	};
+}    // namespace CR::Graphics
+
+namespace std {
+	template<>
+	struct hash<CR::Graphics::PipelineVariant> {
+		std::size_t operator()(CR::Graphics::PipelineVariant const& a_arg) const noexcept {
+			std::size_t result = std::hash<uint8_t>{}((uint8_t)a_arg.Blend) ^
+			                     (std::hash<uint32_t>{}((uint32_t)a_arg.Samples) << 1) ^
+			                     (std::hash<float>{}(a_arg.MinSampleShading) << 2) ^
+			                     (std::hash<bool>{}(a_arg.AlphaToCoverage) << 3);
+			for(uint32_t i = 0; i < a_arg.SpecConstants.size(); ++i) {
+				result ^= std::hash<int32_t>{}(a_arg.SpecConstants[i]) << (i + 4);
+			}
+			return result;
+		}
+	};
+}    // namespace std
+
 namespace CR::Graphics {
 	struct CreatePipelineArgs {
-		Core::Span<const std::byte> ShaderModule;    // crsm file
+		Core::Span<const std::byte> ShaderModule;    // crsm file, must stay alive until the pipeline is destroyed
 		vk::VertexInputBindingDescription BindingDesc;
 		std::vector<vk::VertexInputAttributeDescription> AttribDescription;
+		// Compiled right away, every other variant is compiled the first time it is asked for.
+		PipelineVariant DefaultVariant;
 	};
 
+	// One shader, and all the variants of it that have been asked for. Variants share one layout and descriptor set
+	// layout, so they can all use the same descriptor sets. The layouts are ready as soon as the Pipeline is
+	// constructed, but each vk::Pipeline is compiled on the PipelineCompileThread. Don't draw with a variant until
+	// IsReady returns true for it.
 	class Pipeline {
 	  public:
 		Pipeline() = default;
@@ -25,22 +77,41 @@ namespace CR::Graphics {
 		Pipeline& operator=(const Pipeline&) = delete;
 		Pipeline& operator                   =(Pipeline&& a_other) noexcept;
 
-		operator bool() const { return (bool)m_pipeline; }
+		operator bool() const { return (bool)m_pipeLineLayout; }
 
-		[[nodiscard]] const vk::Pipeline& GetHandle() const { return m_pipeline; }
+		// Never blocks. Starts compiling the variant if this is the first time it was asked for, and picks up the
+		// compiled pipeline once the compile thread is done with it.
+		[[nodiscard]] bool IsReady(const PipelineVariant& a_variant);
+		[[nodiscard]] bool IsReady() { return IsReady(m_defaultVariant); }
+
+		// Variant must be ready
+		[[nodiscard]] const vk::Pipeline& GetHandle(const PipelineVariant& a_variant) const;
+		[[nodiscard]] const vk::Pipeline& GetHandle() const { return GetHandle(m_defaultVariant); }
 		[[nodiscard]] const vk::PipelineLayout& GetLayout() const { return m_pipeLineLayout; }
 		[[nodiscard]] const vk::DescriptorSetLayout& GetDescLayout() const { return m_descriptorSetLayout; }
 
-		void Frame(vk::DescriptorSet& a_set);
+		// Returns true if a_set was updated with newly loaded textures.
+		bool Frame(vk::DescriptorSet& a_set);
 
 	  private:
+		struct Variant {
+			vk::Pipeline Handle;
+			std::future<vk::Pipeline> Pending;
+		};
+		// Only touched by the compile thread once created, shader modules and the base pipeline for derivatives.
+		struct CompileState;
+
+		Variant& RequestVariant(const PipelineVariant& a_variant);
 		void Free();
 
 		vk::PipelineLayout m_pipeLineLayout;
-		vk::Pipeline m_pipeline;
 		vk::DescriptorSetLayout m_descriptorSetLayout;
 		vk::Sampler m_sampler;
 
+		PipelineVariant m_defaultVariant;
+		tsl::robin_map<PipelineVariant, Variant> m_variants;
+		std::shared_ptr<CompileState> m_compileState;
+
 		uint32_t m_lastTextureVersion{0};
 	};
 }    // namespace CR::Graphics
@@ -0,0 +1,126 @@
+﻿#include "PipelineCache.h"
+
+#include "HostAllocator.h"
+
+#include "core/BinaryStream.h"
+#include "core/Log.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	// Our own header in front of the drivers cache data. Some drivers don't validate the data they are given very
+	// well, so never hand them a cache from a different device or driver version.
+#pragma pack(1)
+	constexpr uint32_t c_FourCC  = 'CRPC';
+	constexpr uint16_t c_Version = 1;
+	struct Header {
+		uint32_t FourCC{c_FourCC};
+		uint16_t Version{c_Version};
+		uint32_t VendorID{0};
+		uint32_t DeviceID{0};
+		uint32_t DriverVersion{0};
+		uint8_t CacheUUID[VK_UUID_SIZE]{};
+		uint32_t DataSize{0};
+	};
+#pragma pack()
+
+	vk::Device g_device;
+	vk::PipelineCache g_cache;
+	filesystem::path g_path;
+	Header g_expectedHeader;
+
+	vector<byte> LoadFile(const filesystem::path& a_path) {
+		vector<byte> result;
+		ifstream file(a_path, ios::binary | ios::ate);
+		if(!file) { return result; }
+		result.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)result.data(), result.size());
+		if(!file) { result.clear(); }
+		return result;
+	}
+
+	// Anything wrong with the file just means starting with an empty cache.
+	vector<byte> GetInitialData(const vector<byte>& a_file) {
+		vector<byte> result;
+		if(a_file.size() < sizeof(Header)) { return result; }
+
+		Header header;
+		Core::BinaryReader reader;
+		reader.Data   = a_file.data();
+		reader.Offset = 0;
+		reader.Size   = (uint32_t)a_file.size();
+		Core::Read(reader, header);
+
+		if(header.FourCC != c_FourCC || header.Version != c_Version) {
+			Core::Log::Info("Pipeline cache file is not a valid pipeline cache, ignoring it");
+			return result;
+		}
+		if(header.VendorID != g_expectedHeader.VendorID || header.DeviceID != g_expectedHeader.DeviceID ||
+		   header.DriverVersion != g_expectedHeader.DriverVersion ||
+		   memcmp(header.CacheUUID, g_expectedHeader.CacheUUID, VK_UUID_SIZE) != 0) {
+			Core::Log::Info("Pipeline cache is from a different device or driver, ignoring it");
+			return result;
+		}
+		if(header.DataSize != reader.Size - reader.Offset) {
+			Core::Log::Info("Pipeline cache file is truncated, ignoring it");
+			return result;
+		}
+
+		result.assign(a_file.begin() + reader.Offset, a_file.end());
+		return result;
+	}
+
+	void SaveFile() {
+		auto cacheData = g_device.getPipelineCacheData(g_cache);
+
+		Header header   = g_expectedHeader;
+		header.DataSize = (uint32_t)cacheData.size();
+
+		vector<byte> buffer;
+		Core::Write(buffer, header);
+		buffer.insert(buffer.end(), (const byte*)cacheData.data(), (const byte*)cacheData.data() + cacheData.size());
+
+		ofstream file(g_path, ios::binary | ios::trunc);
+		file.write((const char*)buffer.data(), buffer.size());
+		if(!file) { Core::Log::Warn("Failed to save pipeline cache to {}", g_path.string()); }
+	}
+}    // namespace
+
+void PipelineCache::Init(const vk::PhysicalDevice& a_physicalDevice, const vk::Device& a_device,
+                         const filesystem::path& a_path) {
+	g_device = a_device;
+	g_path   = a_path;
+
+	auto props                     = a_physicalDevice.getProperties();
+	g_expectedHeader.VendorID      = props.vendorID;
+	g_expectedHeader.DeviceID      = props.deviceID;
+	g_expectedHeader.DriverVersion = props.driverVersion;
+	memcpy(g_expectedHeader.CacheUUID, props.pipelineCacheUUID.data(), VK_UUID_SIZE);
+
+	vector<byte> initialData;
+	if(!g_path.empty()) { initialData = GetInitialData(LoadFile(g_path)); }
+	Core::Log::Info("Pipeline cache loaded with {} bytes", initialData.size());
+
+	vk::PipelineCacheCreateInfo cacheInfo;
+	cacheInfo.initialDataSize = initialData.size();
+	cacheInfo.pInitialData    = initialData.data();
+	g_cache                   = g_device.createPipelineCache(cacheInfo, HostAllocator::Get());
+}
+
+void PipelineCache::Shutdown() {
+	if(!g_path.empty()) { SaveFile(); }
+	g_device.destroyPipelineCache(g_cache, HostAllocator::Get());
+	g_cache  = vk::PipelineCache{};
+	g_device = vk::Device{};
+}
+
+const vk::PipelineCache& PipelineCache::Get() {
+	return g_cache;
+}
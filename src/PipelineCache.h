@@ -0,0 +1,15 @@
+﻿#pragma once
+
+#include "VulkanWindows.h"
+
+#include <filesystem>
+
+// One vk::PipelineCache shared by every pipeline. If given a path, it is loaded from there at startup and written back
+// at shutdown, so pipelines don't have to be recompiled from spir-v every run.
+namespace CR::Graphics::PipelineCache {
+	void Init(const vk::PhysicalDevice& a_physicalDevice, const vk::Device& a_device,
+	          const std::filesystem::path& a_path);
+	void Shutdown();
+
+	[[nodiscard]] const vk::PipelineCache& Get();
+}    // namespace CR::Graphics::PipelineCache
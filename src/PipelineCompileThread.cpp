@@ -0,0 +1,62 @@
+﻿#include "PipelineCompileThread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace CR::Graphics;
+
+namespace {
+	struct Request {
+		PipelineCompileThread::task_t Task;
+		promise<vk::Pipeline> Result;
+	};
+
+	thread m_thread;
+	atomic_bool m_running;
+	mutex m_requestMutex;
+	condition_variable m_notify;
+	deque<Request> m_requests;
+
+	void ThreadMain() {
+		while(m_running.load(memory_order_acquire)) {
+			Request request;
+			{
+				unique_lock<mutex> lock(m_requestMutex);
+				if(m_requests.empty()) { m_notify.wait(lock); }
+
+				if(!m_requests.empty()) {
+					request = move(m_requests.front());
+					m_requests.pop_front();
+				}
+			}
+			if(request.Task) { request.Result.set_value(request.Task()); }
+		}
+		m_requests.clear();
+	}
+}    // namespace
+
+void PipelineCompileThread::Init() {
+	m_running.store(true, memory_order_release);
+	m_thread = thread([]() { ThreadMain(); });
+}
+
+void PipelineCompileThread::Shutdown() {
+	m_running.store(false, memory_order_release);
+	m_notify.notify_one();
+	m_thread.join();
+}
+
+future<vk::Pipeline> PipelineCompileThread::Compile(task_t&& a_task) {
+	Request request;
+	request.Task                = move(a_task);
+	future<vk::Pipeline> result = request.Result.get_future();
+	{
+		unique_lock<mutex> lock(m_requestMutex);
+		m_requests.push_back(move(request));
+	}
+	m_notify.notify_one();
+	return result;
+}
@@ -0,0 +1,18 @@
+﻿#pragma once
+
+#include "VulkanWindows.h"
+
+#include <3rdParty/function2.h>
+
+#include <future>
+
+// Pipelines take a long time to create on some drivers, so they are compiled here instead of on the render thread.
+// Tasks run in the order they are given.
+namespace CR::Graphics::PipelineCompileThread {
+	using task_t = fu2::unique_function<vk::Pipeline()>;
+
+	void Init();
+	void Shutdown();
+
+	[[nodiscard]] std::future<vk::Pipeline> Compile(task_t&& a_task);
+}    // namespace CR::Graphics::PipelineCompileThread
@@ -0,0 +1,136 @@
+﻿#include "RecordingThreads.h"
+
+#include "CommandPool.h"
+#include "Commands.h"
+#include "Constants.h"
+#include "EngineInternal.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	constexpr uint32_t c_maxThreads = 4;
+
+	struct Request {
+		RecordingThreads::task_t Task;
+		uint64_t FrameNumber{0};
+		vk::CommandBufferInheritanceInfo Inheritance;
+		glm::ivec2 WindowSize{0, 0};
+		promise<vk::CommandBuffer> Result;
+	};
+
+	vector<thread> m_threads;
+	atomic_bool m_running;
+	mutex m_requestMutex;
+	condition_variable m_notify;
+	deque<Request> m_requests;
+
+	// render thread only
+	vector<future<vk::CommandBuffer>> m_pending;
+
+	void ThreadMain() {
+		CommandPool pools[c_maxFramesInFlight];
+		vector<CommandBuffer> recorded[c_maxFramesInFlight];
+		uint64_t poolFrame[c_maxFramesInFlight];
+		for(uint32_t i = 0; i < c_maxFramesInFlight; ++i) {
+			pools[i]     = CommandPool(CommandPool::PoolType::Secondary);
+			poolFrame[i] = numeric_limits<uint64_t>::max();
+		}
+
+		while(m_running.load(memory_order_acquire)) {
+			Request request;
+			{
+				unique_lock<mutex> lock(m_requestMutex);
+				if(m_requests.empty()) { m_notify.wait(lock); }
+
+				if(!m_requests.empty()) {
+					request = move(m_requests.front());
+					m_requests.pop_front();
+				}
+			}
+			if(!request.Task) { continue; }
+
+			// First task this frame for this frame index. Engine already waited for the gpu to finish the last frame
+			// that used it, so everything recorded back then can be reused.
+			uint32_t frameIndex = (uint32_t)(request.FrameNumber % c_maxFramesInFlight);
+			if(poolFrame[frameIndex] != request.FrameNumber) {
+				recorded[frameIndex].clear();
+				pools[frameIndex].Reset();
+				poolFrame[frameIndex] = request.FrameNumber;
+			}
+
+			CommandBuffer& cmdBuffer = recorded[frameIndex].emplace_back(pools[frameIndex].CreateCommandBuffer());
+			cmdBuffer.Begin(request.Inheritance, true);
+			Commands::SetViewport(cmdBuffer, request.WindowSize);
+			request.Task(cmdBuffer);
+			cmdBuffer.End();
+			request.Result.set_value(cmdBuffer.GetHandle());
+		}
+		// buffers go back to the pools before the pools are destroyed
+		for(auto& frameBuffers : recorded) { frameBuffers.clear(); }
+	}
+}    // namespace
+
+void RecordingThreads::Init() {
+	uint32_t numThreads = std::clamp(thread::hardware_concurrency(), 2u, c_maxThreads + 1) - 1;
+	m_running.store(true, memory_order_release);
+	for(uint32_t i = 0; i < numThreads; ++i) {
+		m_threads.emplace_back([]() { ThreadMain(); });
+	}
+}
+
+void RecordingThreads::Shutdown() {
+	m_running.store(false, memory_order_release);
+	m_notify.notify_all();
+	for(auto& worker : m_threads) { worker.join(); }
+	m_threads.clear();
+	m_requests.clear();
+	m_pending.clear();
+}
+
+void RecordingThreads::Record(task_t&& a_task) {
+	Request request;
+	request.Task                    = move(a_task);
+	request.FrameNumber             = GetFrameNumber();
+	request.Inheritance.renderPass  = GetRenderPass();
+	request.Inheritance.subpass     = 0;
+	request.Inheritance.framebuffer = GetFrameBuffer();
+	request.WindowSize              = GetWindowSize();
+	m_pending.push_back(request.Result.get_future());
+	{
+		unique_lock<mutex> lock(m_requestMutex);
+		m_requests.push_back(move(request));
+	}
+	m_notify.notify_one();
+}
+
+uint32_t RecordingThreads::GetThreadCount() {
+	return (uint32_t)m_threads.size();
+}
+
+void RecordingThreads::Reuse(const vk::CommandBuffer& a_secondary) {
+	promise<vk::CommandBuffer> recorded;
+	recorded.set_value(a_secondary);
+	m_pending.push_back(recorded.get_future());
+}
+
+void RecordingThreads::Execute(CommandBuffer& a_primary) {
+	if(m_pending.empty()) { return; }
+
+	vector<vk::CommandBuffer> secondaries;
+	secondaries.reserve(m_pending.size());
+	for(auto& pending : m_pending) { secondaries.push_back(pending.get()); }
+	m_pending.clear();
+
+	Commands::ExecuteCommands(a_primary, Core::Span<const vk::CommandBuffer>{secondaries.data(), secondaries.size()});
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include "VulkanWindows.h"
+
+#include <3rdParty/function2.h>
+
+namespace CR::Graphics {
+	class CommandBuffer;
+}
+
+// Records draw batches into secondary command buffers on a few worker threads, so recording cost scales with cores.
+// Each worker has its own secondary command pools, one per frame in flight. Render thread only, outside of the workers.
+namespace CR::Graphics::RecordingThreads {
+	// The command buffer is already begun, inside the main render pass with viewport and scissor set. Task must only
+	// record draw commands, and can run on any worker, in any order relative to other tasks.
+	using task_t = fu2::unique_function<void(CommandBuffer&)>;
+
+	void Init();
+	void Shutdown();
+
+	// Must be called during Graphics::Frame, after the frame buffer has been acquired. Everything the task needs from
+	// the engine should be captured here, on the render thread.
+	void Record(task_t&& a_task);
+	// How many tasks can record at once. Worth splitting a frame's draws into about this many tasks.
+	[[nodiscard]] uint32_t GetThreadCount();
+	// Executes an already recorded secondary, in order with the tasks passed to Record this frame.
+	void Reuse(const vk::CommandBuffer& a_secondary);
+	// Waits for everything passed to Record this frame, and executes the secondaries into a_primary in the order they
+	// were recorded. Render pass must have been begun with eSecondaryCommandBuffers.
+	void Execute(CommandBuffer& a_primary);
+}    // namespace CR::Graphics::RecordingThreads
@@ -1,7 +1,9 @@
 ﻿#include "Graphics/SpriteBasic.h"
 
+#include "ApiRecorder.h"
 #include "EngineInternal.h"
 #include "SpriteManagerBasic.h"
+#include "SpriteTemplateBasicImpl.h"
 
 using namespace std;
 using namespace CR;
@@ -9,10 +11,14 @@ using namespace CR::Graphics;
 
 SpriteBasic::SpriteBasic(const SpriteBasicCreateInfo& a_info) {
 	m_index = GetSpriteManagerBasic().CreateSprite(a_info.Name, a_info.Template);
+	ApiRecorder::CreateSprite(m_index, a_info.Name, ((SpriteTemplateBasicImpl*)a_info.Template.get())->GetIndex());
 }
 
 SpriteBasic::~SpriteBasic() {
-	if(m_index != c_unused) { GetSpriteManagerBasic().FreeSprite(m_index); }
+	if(m_index != c_unused) {
+		ApiRecorder::DestroySprite(m_index);
+		GetSpriteManagerBasic().FreeSprite(m_index);
+	}
 }
 
 SpriteBasic::SpriteBasic(SpriteBasic&& a_other) noexcept {
@@ -20,7 +26,10 @@ SpriteBasic::SpriteBasic(SpriteBasic&& a_other) noexcept {
 }
 
 SpriteBasic& SpriteBasic::operator=(SpriteBasic&& a_other) noexcept {
-	if(m_index != c_unused) { GetSpriteManagerBasic().FreeSprite(m_index); }
+	if(m_index != c_unused) {
+		ApiRecorder::DestroySprite(m_index);
+		GetSpriteManagerBasic().FreeSprite(m_index);
+	}
 	m_index         = a_other.m_index;
 	a_other.m_index = c_unused;
 
@@ -28,13 +37,16 @@ SpriteBasic& SpriteBasic::operator=(SpriteBasic&& a_other) noexcept {
 }
 
 void SpriteBasic::SetPosition(const glm::vec2& a_position) {
+	ApiRecorder::SetSpritePosition(m_index, a_position);
 	GetSpriteManagerBasic().SetSpritePosition(m_index, a_position);
 }
 
 void SpriteBasic::SetColor(const glm::vec4& a_color) {
+	ApiRecorder::SetSpriteColor(m_index, a_color);
 	GetSpriteManagerBasic().SetSpriteColor(m_index, a_color);
 }
 
 void SpriteBasic::SetRotation(float a_rotation) {
+	ApiRecorder::SetSpriteRotation(m_index, a_rotation);
 	GetSpriteManagerBasic().SetSpriteRotation(m_index, a_rotation);
 }
\ No newline at end of file
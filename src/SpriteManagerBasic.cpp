@@ -2,16 +2,35 @@
 
 #include "Commands.h"
 #include "Constants.h"
+#include "EngineInternal.h"
+#include "RecordingThreads.h"
 #include "SpriteTemplateBasicImpl.h"
 #include "shaders/Basic.h"
 
 #include "core/Log.h"
 
+#include <algorithm>
+
 using namespace std;
 using namespace CR;
 using namespace CR::Core;
 using namespace CR::Graphics;
 
+namespace {
+	BlendMode ToBlendMode(eBlendMode a_mode) {
+		switch(a_mode) {
+			case eBlendMode::Alpha:
+				return BlendMode::Alpha;
+			case eBlendMode::PremultipliedAlpha:
+				return BlendMode::PremultipliedAlpha;
+			case eBlendMode::Additive:
+				return BlendMode::Additive;
+			default:
+				return BlendMode::None;
+		}
+	}
+}    // namespace
+
 SpriteManagerBasic::SpriteManagerBasic() {
 	m_spriteTemplates.Used.reset();
 	m_sprites.Used.reset();
@@ -29,9 +48,17 @@ SpriteManagerBasic::SpriteManagerBasic() {
 	pipeInfo.ShaderModule      = embed::GetBasic();
 	pipeInfo.BindingDesc       = m_vertexBuffer.GetBindingDescription();
 	pipeInfo.AttribDescription = m_vertexBuffer.GetAttrDescriptions();
-	Pipeline                   = Graphics::Pipeline(pipeInfo);
+
+	pipeInfo.DefaultVariant.Samples          = GetSampleCount();
+	pipeInfo.DefaultVariant.MinSampleShading = GetSampleShading() ? 1.0f : 0.0f;
+	pipeInfo.DefaultVariant.AlphaToCoverage  = GetSampleCount() != vk::SampleCountFlagBits::e1;
+	m_defaultVariant                         = pipeInfo.DefaultVariant;
+
+	Pipeline = Graphics::Pipeline(pipeInfo);
 
 	DescSet = CreateDescriptorSet(Pipeline.GetDescLayout());
+
+	m_commandPool = CommandPool(CommandPool::PoolType::Secondary);
 }
 
 SpriteManagerBasic::~SpriteManagerBasic() {
@@ -39,8 +66,7 @@ SpriteManagerBasic::~SpriteManagerBasic() {
 	                  "not all sprite types were deleted when shutting down the graphics engine");
 }
 
-uint8_t SpriteManagerBasic::CreateTemplate(const std::string_view a_name, const glm::uvec2& a_frameSize,
-                                           eFrameRate frameRate, const char* a_textureName) {
+uint8_t SpriteManagerBasic::CreateTemplate(const SpriteTemplateBasicCreateInfo& a_info) {
 	size_t result = c_maxSpriteTemplates;
 	for(size_t i = 0; i < c_maxSpriteTemplates; ++i) {
 		if(!m_spriteTemplates.Used[i]) {
@@ -51,12 +77,20 @@ uint8_t SpriteManagerBasic::CreateTemplate(const std::string_view a_name, const
 	Core::Log::Require(result != c_maxSpriteTemplates, "Ran out of available sprite templates");
 
 	m_spriteTemplates.Used[result]           = true;
-	m_spriteTemplates.Ready[result]          = false;
-	m_spriteTemplates.Names[result]          = a_name;
-	m_spriteTemplates.FrameSizes[result]     = a_frameSize;
-	m_spriteTemplates.TextureIndices[result] = TextureSets::GetTextureIndex(a_textureName);
+	m_spriteTemplates.Names[result]          = a_info.Name;
+	m_spriteTemplates.FrameSizes[result]     = a_info.FrameSize;
+	m_spriteTemplates.TextureIndices[result] = TextureSets::GetTextureIndex(a_info.TextureName.c_str());
+	// texture may have finished loading before the template was created, otherwise TexturesLoaded will pick it up.
+	m_spriteTemplates.Ready[result]          = TextureSets::IsReady(m_spriteTemplates.TextureIndices[result]);
 	m_spriteTemplates.MaxFrames[result]      = TextureSets::GetMaxFrames(m_spriteTemplates.TextureIndices[result]);
-	m_spriteTemplates.FrameRates[result]     = frameRate;
+	m_spriteTemplates.FrameRates[result]     = a_info.FrameRate;
+
+	PipelineVariant& variant = m_spriteTemplates.Variants[result];
+	variant                  = m_defaultVariant;
+	variant.Blend            = ToBlendMode(a_info.BlendMode);
+	if(!a_info.SampleShading) { variant.MinSampleShading = 0.0f; }
+	// starts it compiling if no other template has asked for this variant yet.
+	m_spriteTemplates.PipelineReady[result] = Pipeline.IsReady(variant);
 
 	return (uint8_t)result;
 }
@@ -64,7 +98,8 @@ uint8_t SpriteManagerBasic::CreateTemplate(const std::string_view a_name, const
 void SpriteManagerBasic::FreeTemplate(uint8_t a_index) {
 	m_spriteTemplates.Names[a_index].clear();
 	m_spriteTemplates.Names[a_index].shrink_to_fit();
-	m_spriteTemplates.Used[a_index] = false;
+	m_spriteTemplates.Used[a_index]          = false;
+	m_spriteTemplates.PipelineReady[a_index] = false;
 }
 
 uint16_t SpriteManagerBasic::CreateSprite(const std::string_view a_name,
@@ -88,6 +123,7 @@ uint16_t SpriteManagerBasic::CreateSprite(const std::string_view a_name,
 	m_sprites.Colors[result]          = glm::vec4(1.0f);
 	m_sprites.Positions[result]       = glm::vec2(0.0f);
 	m_sprites.Rotations[result]       = 0.0f;
+	m_dirty                           = true;
 
 	return (uint16_t)result;
 }
@@ -97,70 +133,92 @@ void SpriteManagerBasic::FreeSprite(uint16_t a_index) {
 	m_sprites.Names[a_index].shrink_to_fit();
 	m_sprites.Templates[a_index].reset();
 	m_sprites.Used[a_index] = false;
+	m_dirty                 = true;
 }
 
-void SpriteManagerBasic::Frame(CommandBuffer& a_commandBuffer) {
-	++m_currentFrame;
-
+void SpriteManagerBasic::TexturesLoaded(Core::Span<const uint16_t> a_textureIndices) {
+	if(a_textureIndices.size() == 0) { return; }
 	for(size_t i = 0; i < c_maxSpriteTemplates; ++i) {
-		if(m_spriteTemplates.Used[i] && !m_spriteTemplates.Ready[i]) {
-			m_spriteTemplates.Ready[i] = TextureSets::IsReady(m_spriteTemplates.TextureIndices[i]);
+		if(!m_spriteTemplates.Used[i] || m_spriteTemplates.Ready[i]) { continue; }
+		for(uint32_t tex = 0; tex < a_textureIndices.size(); ++tex) {
+			if(m_spriteTemplates.TextureIndices[i] == a_textureIndices[tex]) {
+				m_spriteTemplates.Ready[i] = true;
+				break;
+			}
 		}
 	}
+}
 
-	Pipeline.Frame(DescSet);
+bool SpriteManagerBasic::Update() {
+	++m_currentFrame;
+	bool changed = m_dirty;
+	m_dirty      = false;
 
-	Vertex* spriteData    = m_vertexBuffer.begin();
-	m_numSpritesThisFrame = 0;
+	// Descriptors are update after bind, so cached draws would see this anyway. Cheap enough to re-record to be safe.
+	if(Pipeline.Frame(DescSet)) {
+		for(auto& cached : m_cachedDraws) { cached.Valid = false; }
+		changed = true;
+	}
+
+	// Pipeline variants compile in the background, a template's sprites aren't drawn until its variant is done.
+	for(size_t i = 0; i < c_maxSpriteTemplates; ++i) {
+		if(!m_spriteTemplates.Used[i] || m_spriteTemplates.PipelineReady[i]) { continue; }
+		if(Pipeline.IsReady(m_spriteTemplates.Variants[i])) {
+			m_spriteTemplates.PipelineReady[i] = true;
+			changed                            = true;
+		}
+	}
 
 	for(uint32_t sprite = 0; sprite < c_maxSprites; ++sprite) {
 		if(!m_sprites.Used[sprite]) { continue; }
 		auto& templIndex = m_sprites.TemplateIndices[sprite];
 		if(!m_spriteTemplates.Ready[templIndex]) { continue; }
 
+		// in 60hz frames
+		uint32_t period = 0;
 		switch(m_spriteTemplates.FrameRates[templIndex]) {
 			case eFrameRate::None:
 				// Nothing to do
 				break;
 			case eFrameRate::FPS10:
-				if(m_currentFrame % (6 * GetFrameRateDivisor()) == 0) {
-					++m_sprites.CurrentFrame[sprite];
-					m_sprites.CurrentFrame[sprite] %= m_spriteTemplates.MaxFrames[templIndex];
-				}
+				period = 6;
 				break;
 			case eFrameRate::FPS12:
-				if(m_currentFrame % (5 * GetFrameRateDivisor()) == 0) {
-					++m_sprites.CurrentFrame[sprite];
-					m_sprites.CurrentFrame[sprite] %= m_spriteTemplates.MaxFrames[templIndex];
-				}
+				period = 5;
 				break;
 			case eFrameRate::FPS15:
-				if(m_currentFrame % (4 * GetFrameRateDivisor()) == 0) {
-					++m_sprites.CurrentFrame[sprite];
-					m_sprites.CurrentFrame[sprite] %= m_spriteTemplates.MaxFrames[templIndex];
-				}
+				period = 4;
 				break;
 			case eFrameRate::FPS20:
-				if(m_currentFrame % (3 * GetFrameRateDivisor()) == 0) {
-					++m_sprites.CurrentFrame[sprite];
-					m_sprites.CurrentFrame[sprite] %= m_spriteTemplates.MaxFrames[templIndex];
-				}
+				period = 3;
 				break;
 			case eFrameRate::FPS30:
-				if(m_currentFrame % (2 * GetFrameRateDivisor()) == 0) {
-					++m_sprites.CurrentFrame[sprite];
-					m_sprites.CurrentFrame[sprite] %= m_spriteTemplates.MaxFrames[templIndex];
-				}
+				period = 2;
+				break;
+			case eFrameRate::FPS60:
+				period = 1;
 				break;
-			case eFrameRate::FPS60: {
-				if(m_currentFrame % (1 * GetFrameRateDivisor()) == 0) {
-					++m_sprites.CurrentFrame[sprite];
-					m_sprites.CurrentFrame[sprite] %= m_spriteTemplates.MaxFrames[templIndex];
-				}
-			} break;
 			default:
 				break;
 		}
+		if(period > 0 && m_currentFrame % (period * GetFrameRateDivisor()) == 0) {
+			uint16_t frame = (uint16_t)((m_sprites.CurrentFrame[sprite] + 1) % m_spriteTemplates.MaxFrames[templIndex]);
+			changed |= frame != m_sprites.CurrentFrame[sprite];
+			m_sprites.CurrentFrame[sprite] = frame;
+		}
+	}
+	return changed;
+}
+
+void SpriteManagerBasic::Frame(CommandBuffer& a_commandBuffer) {
+	Vertex* spriteData    = m_vertexBuffer.begin();
+	m_numSpritesThisFrame = 0;
+	m_batches.clear();
+
+	for(uint32_t sprite = 0; sprite < c_maxSprites; ++sprite) {
+		if(!m_sprites.Used[sprite]) { continue; }
+		auto& templIndex = m_sprites.TemplateIndices[sprite];
+		if(!m_spriteTemplates.Ready[templIndex] || !m_spriteTemplates.PipelineReady[templIndex]) { continue; }
 
 		float sinAngle = sin(m_sprites.Rotations[sprite]);
 		float cosAngle = cos(m_sprites.Rotations[sprite]);
@@ -172,20 +230,85 @@ void SpriteManagerBasic::Frame(CommandBuffer& a_commandBuffer) {
 		spriteData->FrameSize    = m_spriteTemplates.FrameSizes[templIndex];
 		spriteData->Rotation     = glm::vec4{rot[0][0], rot[0][1], rot[1][0], rot[1][1]};
 
+		// Only consecutive sprites are batched, so draw order stays sprite order.
+		const PipelineVariant& variant = m_spriteTemplates.Variants[templIndex];
+		if(m_batches.empty() || !(m_batches.back().Variant == variant)) {
+			m_batches.push_back({variant, m_numSpritesThisFrame, 0});
+		}
+		++m_batches.back().NumSprites;
+
 		++spriteData;
 		++m_numSpritesThisFrame;
 	}
 	m_vertexBuffer.Release(a_commandBuffer);
 }
 
-void SpriteManagerBasic::Draw(CommandBuffer& a_commandBuffer) {
+void SpriteManagerBasic::AcquireVertexBuffer(CommandBuffer& a_commandBuffer) {
+	m_vertexBuffer.Acquire(a_commandBuffer);
+}
+
+void SpriteManagerBasic::RecordDraws() {
+	if(m_batches.empty()) { return; }
+
+	// Too few sprites per task and the task overhead is more than the recording it saves.
+	constexpr uint32_t c_minSpritesPerTask = 256;
+
+	uint32_t numTasks       = std::clamp(m_numSpritesThisFrame / c_minSpritesPerTask, 1u,
+	                                     std::max(RecordingThreads::GetThreadCount(), 1u));
+	uint32_t spritesPerTask = (m_numSpritesThisFrame + numTasks - 1) / numTasks;
+	glm::ivec2 windowSize   = GetWindowSize();
+	for(uint32_t first = 0; first < m_numSpritesThisFrame; first += spritesPerTask) {
+		uint32_t count = std::min(spritesPerTask, m_numSpritesThisFrame - first);
+		RecordingThreads::Record([this, windowSize, first, count](CommandBuffer& a_cmdBuffer) {
+			Draw(a_cmdBuffer, windowSize, first, count);
+		});
+	}
+}
+
+void SpriteManagerBasic::Draw(CommandBuffer& a_commandBuffer, const glm::ivec2& a_windowSize, uint32_t a_firstSprite,
+                              uint32_t a_numSprites) {
 	Core::Log::Assert(Pipeline, "Sprite type didn't have a pipeline");
 
-	m_vertexBuffer.Acquire(a_commandBuffer);
-	if(m_numSpritesThisFrame > 0) {
-		Commands::BindPipeline(a_commandBuffer, Pipeline);
-		Commands::BindVertexBuffer(a_commandBuffer, m_vertexBuffer.GetHandle());
-		Commands::BindDescriptorSet(a_commandBuffer, Pipeline, DescSet);
-		Commands::Draw(a_commandBuffer, 4, m_numSpritesThisFrame);
+	// Every variant shares the pipeline layout, so the push constants and bindings carry over between batches.
+	uint32_t endSprite = a_firstSprite + a_numSprites;
+	bool bound         = false;
+	for(const Batch& batch : m_batches) {
+		uint32_t first = std::max(batch.FirstSprite, a_firstSprite);
+		uint32_t last  = std::min(batch.FirstSprite + batch.NumSprites, endSprite);
+		if(first >= last) { continue; }
+
+		Commands::BindPipeline(a_commandBuffer, Pipeline, batch.Variant);
+		if(!bound) {
+			glm::vec2 invScreenSize = 1.0f / glm::vec2(a_windowSize);
+			Commands::PushConstants(a_commandBuffer, Pipeline, {(std::byte*)&invScreenSize, sizeof(invScreenSize)});
+			Commands::BindVertexBuffer(a_commandBuffer, m_vertexBuffer.GetHandle(), m_vertexBuffer.GetOffset());
+			Commands::BindDescriptorSet(a_commandBuffer, Pipeline, DescSet);
+			bound = true;
+		}
+		Commands::Draw(a_commandBuffer, 4, last - first, first);
+	}
+}
+
+void SpriteManagerBasic::DrawCached() {
+	if(m_batches.empty()) { return; }
+
+	// Vertex buffer offset differs per frame in flight, so one cached draw for each. Frame buffer is left out of the
+	// inheritance info so swap chain images don't matter.
+	CachedDraw& cached = m_cachedDraws[GetFrameIndex()];
+	if(!cached.Valid || cached.Batches != m_batches || cached.WindowSize != GetWindowSize()) {
+		if(!cached.Buffer.GetHandle()) { cached.Buffer = m_commandPool.CreateCommandBuffer(); }
+
+		vk::CommandBufferInheritanceInfo inheritance;
+		inheritance.renderPass = GetRenderPass();
+		inheritance.subpass    = 0;
+		cached.Buffer.Begin(inheritance, false);
+		Commands::SetViewport(cached.Buffer, GetWindowSize());
+		Draw(cached.Buffer, GetWindowSize(), 0, m_numSpritesThisFrame);
+		cached.Buffer.End();
+
+		cached.Valid      = true;
+		cached.Batches    = m_batches;
+		cached.WindowSize = GetWindowSize();
 	}
+	RecordingThreads::Reuse(cached.Buffer.GetHandle());
 }
@@ -1,12 +1,14 @@
 ﻿#pragma once
 
 #include "CommandPool.h"
+#include "Constants.h"
 #include "DescriptorPool.h"
 #include "Graphics/SpriteBasic.h"
 #include "Graphics/SpriteTemplateBasic.h"
 #include "Pipeline.h"
 #include "UniformBufferDynamic.h"
 #include "VertexBuffer.h"
+#include "core/Span.h"
 #include "types/UNorm.h"
 
 #include <3rdParty/glm.h>
@@ -15,6 +17,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace CR::Graphics {
 	inline constexpr uint32_t c_maxSpriteTemplates = 64;
@@ -30,6 +33,9 @@ namespace CR::Graphics {
 		glm::uvec2 FrameSizes[c_maxSpriteTemplates];
 		eFrameRate FrameRates[c_maxSprites];
 		uint16_t MaxFrames[c_maxSprites];
+		PipelineVariant Variants[c_maxSpriteTemplates];
+		// Variant has finished compiling.
+		std::bitset<c_maxSpriteTemplates> PipelineReady;
 	};
 
 	struct Sprites {
@@ -52,8 +58,7 @@ namespace CR::Graphics {
 		SpriteManagerBasic(SpriteManagerBasic&&)                 = delete;
 		SpriteManagerBasic& operator=(SpriteManagerBasic&&) = delete;
 
-		uint8_t CreateTemplate(std::string_view a_name, const glm::uvec2& a_frameSize, eFrameRate frameRate,
-		                       const char* a_textureName);
+		uint8_t CreateTemplate(const SpriteTemplateBasicCreateInfo& a_info);
 		void FreeTemplate(uint8_t a_index);
 
 		uint16_t CreateSprite(std::string_view a_name, std::shared_ptr<SpriteTemplateBasic> a_template);
@@ -62,11 +67,32 @@ namespace CR::Graphics {
 		void SetSpriteColor(uint16_t a_index, const glm::vec4& a_color);
 		void SetSpriteRotation(uint16_t a_index, float a_rotation);
 
+		// Texture indices that finished loading this frame, from TextureSets::CheckLoadingTasks
+		void TexturesLoaded(Core::Span<const uint16_t> a_textureIndices);
+
+		// Called every Graphics::Frame, even ones that get skipped. Advances animations, returns true if anything
+		// visible changed since the last call.
+		bool Update();
+		// Only called for frames that are actually rendered.
 		void Frame(CommandBuffer& a_commandBuffer);
+		// Waits for this frame's vertex upload. Goes in the primary before the render pass, so the secondaries only
+		// hold draws and a cached one stays valid across frames.
+		void AcquireVertexBuffer(CommandBuffer& a_commandBuffer);
+
+		// Splits this frame's sprites into about one task per recording thread, in sprite order.
+		void RecordDraws();
+		// Same as RecordDraws, but keeps a secondary per frame in flight and only re-records it when the draw would
+		// change. Queues it with RecordingThreads::Reuse.
+		void DrawCached();
 
-		void Draw(CommandBuffer& a_commandBuffer);
+		// Sprites in the last draw, 0 if nothing could be drawn yet.
+		[[nodiscard]] uint32_t GetSpritesDrawn() const { return m_numSpritesThisFrame; }
 
 	  private:
+		// Safe to call from the recording threads, only reads state that is fixed until the next Frame.
+		void Draw(CommandBuffer& a_commandBuffer, const glm::ivec2& a_windowSize, uint32_t a_firstSprite,
+		          uint32_t a_numSprites);
+
 #pragma pack(push)
 #pragma pack(1)
 		struct Vertex {
@@ -78,25 +104,55 @@ namespace CR::Graphics {
 		};
 #pragma pack(pop)
 
+		// A run of sprites, in sprite order, that share a pipeline variant. Drawn with one instanced draw.
+		struct Batch {
+			PipelineVariant Variant;
+			uint32_t FirstSprite{0};
+			uint32_t NumSprites{0};
+
+			bool operator==(const Batch& a_other) const {
+				return Variant == a_other.Variant && FirstSprite == a_other.FirstSprite &&
+				       NumSprites == a_other.NumSprites;
+			}
+		};
+
 		SpriteTemplates m_spriteTemplates;
 		Sprites m_sprites;
 		uint16_t m_currentFrame{0};
 		uint32_t m_numSpritesThisFrame{0};
+		std::vector<Batch> m_batches;
+		bool m_dirty{true};
 
 		Pipeline Pipeline;
+		// Templates start from this, it matches the engine settings.
+		PipelineVariant m_defaultVariant;
 		VertexBuffer<Vertex> m_vertexBuffer;
 		vk::DescriptorSet DescSet;
+
+		// Everything recorded into a cached draw that can change between frames.
+		struct CachedDraw {
+			CommandBuffer Buffer;
+			bool Valid{false};
+			std::vector<Batch> Batches;
+			glm::ivec2 WindowSize{0, 0};
+		};
+		// pool must outlive the cached draws, they go back to it when destroyed.
+		CommandPool m_commandPool;
+		CachedDraw m_cachedDraws[c_maxFramesInFlight];
 	};
 
 	inline void SpriteManagerBasic::SetSpritePosition(uint16_t a_index, const glm::vec2& a_position) {
 		m_sprites.Positions[a_index] = a_position;
+		m_dirty                      = true;
 	}
 
 	inline void SpriteManagerBasic::SetSpriteColor(uint16_t a_index, const glm::vec4& a_color) {
 		m_sprites.Colors[a_index] = a_color;
+		m_dirty                   = true;
 	}
 
 	inline void SpriteManagerBasic::SetSpriteRotation(uint16_t a_index, float a_rotation) {
 		m_sprites.Rotations[a_index] = a_rotation;
+		m_dirty                      = true;
 	}
 }    // namespace CR::Graphics
@@ -1,5 +1,6 @@
 ﻿#include "SpriteTemplateBasicImpl.h"
 
+#include "ApiRecorder.h"
 #include "EngineInternal.h"
 #include "SpriteManagerBasic.h"
 
@@ -10,12 +11,13 @@ using namespace CR::Graphics;
 SpriteTemplateBasicImpl::SpriteTemplateBasicImpl(uint8_t a_index) : m_index(a_index) {}
 
 SpriteTemplateBasicImpl::~SpriteTemplateBasicImpl() {
+	ApiRecorder::DestroySpriteTemplate(m_index);
 	GetSpriteManagerBasic().FreeTemplate(m_index);
 }
 
 std::shared_ptr<Graphics::SpriteTemplateBasic>
     Graphics::CreateSpriteTemplateBasic(const SpriteTemplateBasicCreateInfo& a_info) {
-	uint8_t index = GetSpriteManagerBasic().CreateTemplate(a_info.Name, a_info.FrameSize, a_info.FrameRate,
-	                                                       a_info.TextureName.c_str());
+	uint8_t index = GetSpriteManagerBasic().CreateTemplate(a_info);
+	ApiRecorder::CreateSpriteTemplate(index, a_info);
 	return make_shared<Graphics::SpriteTemplateBasicImpl>(index);
 }
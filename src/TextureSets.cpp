@@ -1,10 +1,15 @@
 ﻿#include "Graphics/TextureSet.h"
 
+#include "ApiRecorder.h"
 #include "AssetLoadingThread.h"
 #include "Commands.h"
+#include "CompletionQueue.h"
 #include "Constants.h"
 #include "EngineInternal.h"
+#include "HostAllocator.h"
+#include "MemoryAllocator.h"
 #include "TextureSets.h"
+#include "Trace.h"
 
 #include "DataCompression/LosslessCompression.h"
 #include "core/BinaryStream.h"
@@ -14,7 +19,9 @@
 
 #include <3rdParty/robinmap.h>
 
+#include <algorithm>
 #include <bitset>
+#include <chrono>
 #include <unordered_map>
 
 using namespace std;
@@ -52,9 +59,28 @@ namespace {
 		vector<Header> m_headers;
 		vector<vk::Image> m_images;
 		vector<vk::ImageView> m_views;
-		vk::DeviceMemory m_imageMemory;
-		vector<std::shared_ptr<std::atomic_bool>> m_loadingTask;
+		vector<Allocation> m_imageMemory;
 		vector<bool> m_ready;
+		uint32_t m_readyCount{0};
+		// decremented by the loading thread, only used to know when its safe to destroy the set.
+		atomic_uint32_t m_pendingLoads{0};
+		// bumped every time a set is destroyed, so completions for a previous user of the set can be ignored.
+		uint32_t m_generation{0};
+		function<void(const string&)> m_loadedCallback;
+	};
+
+	// A descriptor slot that was given a new image view at Version. Removals aren't recorded, the descriptor binding is
+	// partially bound so a freed slot can just be left alone until it gets reused.
+	struct DescriptorChange {
+		uint32_t Version{0};
+		uint16_t DescSlot{0};
+	};
+	constexpr size_t c_maxDescriptorJournal{c_maxTextures * 2};
+
+	struct LoadedTexture {
+		uint16_t Set{0};
+		uint16_t Slot{0};
+		uint32_t Generation{0};
 	};
 
 	uint32_t g_version{0};
@@ -63,8 +89,44 @@ namespace {
 	TextureSetImpl g_textureSets[c_maxTextureSets];
 	tsl::robin_map<string, uint16_t> g_lookup;
 	vk::Buffer g_stagingBuffer;
-	vk::DeviceMemory g_stagingMemory;
+	Allocation g_stagingMemory;
 	void* g_stagingData;
+	// loading thread is the only producer, render thread the only consumer. Can never have more than c_maxTextures
+	// loading at once, with room for that many stale completions from sets destroyed before the render thread saw them.
+	CompletionQueue<LoadedTexture, c_maxTextures * 2> g_completionQueue;
+	vector<LoadedTexture> g_completed;
+	vector<uint16_t> g_readyTextures;
+
+	// journal is in version order. Anything at or before g_journalStartVersion has been trimmed.
+	vector<DescriptorChange> g_descriptorJournal;
+	uint32_t g_journalStartVersion{0};
+	// version the slot's current image view was assigned at, 0 if the slot is free.
+	uint32_t g_slotVersion[c_maxTextures];
+	vk::ImageView g_slotViews[c_maxTextures];
+
+	// TextureLoadStats, Read is bumped on the thread creating the set, the rest on the loading thread.
+	struct LoadStage {
+		atomic_uint64_t Bytes{0};
+		atomic_uint64_t Ns{0};
+	};
+	LoadStage g_readStage;
+	LoadStage g_decodeStage;
+	LoadStage g_stagingStage;
+	LoadStage g_gpuCopyStage;
+	atomic_uint32_t g_texturesLoaded{0};
+
+	void AddLoadStage(LoadStage& a_stage, uint64_t a_bytes, chrono::steady_clock::time_point a_start) {
+		auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - a_start).count();
+		a_stage.Bytes.fetch_add(a_bytes, memory_order_relaxed);
+		a_stage.Ns.fetch_add((uint64_t)ns, memory_order_relaxed);
+	}
+
+	TextureLoadStats::Stage GetLoadStage(const LoadStage& a_stage) {
+		TextureLoadStats::Stage result;
+		result.Bytes = a_stage.Bytes.load(memory_order_relaxed);
+		result.Ms    = a_stage.Ns.load(memory_order_relaxed) / 1'000'000.0f;
+		return result;
+	}
 
 	uint16_t CalcID(uint16_t a_set, uint16_t a_slot) {
 		Core::Log::Assert(a_set < c_maxTextureSets, "invalid set");
@@ -73,28 +135,48 @@ namespace {
 	}
 	uint16_t GetSet(uint16_t a_id) { return a_id >> c_idSetShift; }
 	uint16_t GetSlot(uint16_t a_id) { return a_id & (c_maxTexturesPerSet - 1); }
+
+	void TrimDescriptorJournal() {
+		if(g_descriptorJournal.size() <= c_maxDescriptorJournal) { return; }
+		// cut on a version boundary, so a version is either entirely in the journal or entirely trimmed.
+		uint32_t cutVersion = g_descriptorJournal[g_descriptorJournal.size() / 2].Version;
+		auto afterCut       = [cutVersion](const DescriptorChange& a_change) { return a_change.Version > cutVersion; };
+		auto cutIter        = find_if(begin(g_descriptorJournal), end(g_descriptorJournal), afterCut);
+		g_descriptorJournal.erase(begin(g_descriptorJournal), cutIter);
+		g_journalStartVersion = cutVersion;
+	}
+
+	// render thread only
+	void DrainCompletionQueue() {
+		LoadedTexture loaded;
+		while(g_completionQueue.Pop(loaded)) { g_completed.push_back(loaded); }
+	}
 }    // namespace
 
 TextureSet ::~TextureSet() {
+	Free();
+}
+
+void TextureSet::Free() {
 	if(m_id != c_unused) {
-		uint16_t set = GetSet(m_id);
-		while(!Core::all_of(g_textureSets[set].m_ready, [](const auto& a_rdy) { return a_rdy; })) {
+		ApiRecorder::DestroyTextureSet(m_id);
+		// m_id is the set itself, not a texture id.
+		uint16_t set = m_id;
+		while(g_textureSets[set].m_pendingLoads.load(memory_order_acquire) > 0) {
 			this_thread::sleep_for(64ms);
-
-			for(uint32_t slot = 0; slot < g_textureSets[set].m_ready.size(); ++slot) {
-				if(!g_textureSets[set].m_ready[slot]) {
-					if(g_textureSets[set].m_loadingTask[slot]->load(memory_order_acquire)) {
-						g_textureSets[set].m_loadingTask[slot].reset();
-						g_textureSets[set].m_ready[slot] = true;
-					}
-				}
-			}
+			// keep the queue from filling up while we wait, CheckLoadingTasks will process these later.
+			DrainCompletionQueue();
 		}
 
-		auto& device = GetDevice();
-		for(auto& view : g_textureSets[set].m_views) { device.destroyImageView(view); }
-		for(auto& img : g_textureSets[set].m_images) { device.destroyImage(img); }
-		device.freeMemory(g_textureSets[set].m_imageMemory);
+		// frames still in flight can be sampling these.
+		ExecuteNextFrame([views = move(g_textureSets[set].m_views), images = move(g_textureSets[set].m_images),
+		                  imageMemory = move(g_textureSets[set].m_imageMemory)]() mutable {
+			auto& device = GetDevice();
+			for(auto& view : views) { device.destroyImageView(view, HostAllocator::Get()); }
+			for(auto& img : images) { device.destroyImage(img, HostAllocator::Get()); }
+			for(auto& memory : imageMemory) { MemoryAllocator::Free(memory); }
+		});
+		g_textureSets[set].m_imageMemory.clear();
 
 		for(const auto& name : g_textureSets[set].m_names) { g_lookup.erase(name); }
 
@@ -102,11 +184,18 @@ TextureSet ::~TextureSet() {
 		g_textureSets[set].m_headers.clear();
 		g_textureSets[set].m_images.clear();
 		g_textureSets[set].m_views.clear();
-		g_textureSets[set].m_loadingTask.clear();
 		g_textureSets[set].m_ready.clear();
-		for(const auto& slot : g_textureSets[set].m_textureIndex) { g_textureSlots[slot] = false; }
+		g_textureSets[set].m_readyCount     = 0;
+		g_textureSets[set].m_loadedCallback = nullptr;
+		++g_textureSets[set].m_generation;
+		for(const auto& slot : g_textureSets[set].m_textureIndex) {
+			g_textureSlots[slot] = false;
+			g_slotVersion[slot]  = 0;
+			g_slotViews[slot]    = vk::ImageView{};
+		}
 		g_textureSets[set].m_textureIndex.clear();
-		g_used[m_id] = false;
+		g_used[set] = false;
+		m_id        = c_unused;
 
 		++g_version;
 	}
@@ -117,27 +206,46 @@ TextureSet::TextureSet(TextureSet&& a_other) noexcept {
 }
 
 TextureSet& TextureSet::operator=(TextureSet&& a_other) noexcept {
+	if(this == &a_other) { return *this; }
+	Free();
 	m_id = a_other.m_id;
 
 	a_other.m_id = c_unused;
 	return *this;
 }
 
-void Graphics::TextureSets::CheckLoadingTasks(CommandBuffer& a_cmdBuffer) {
-	for(uint32_t set = 0; set < c_maxTextureSets; ++set) {
-		if(g_used[set]) {
-			for(uint32_t slot = 0; slot < g_textureSets[set].m_ready.size(); ++slot) {
-				if(!g_textureSets[set].m_ready[slot]) {
-					if(g_textureSets[set].m_loadingTask[slot]->load(memory_order_acquire)) {
-						g_textureSets[set].m_loadingTask[slot].reset();
-						Commands::TransitionFromTransferQueue(a_cmdBuffer, g_textureSets[set].m_images[slot],
-						                                      g_textureSets[set].m_headers[slot].Frames);
-						g_textureSets[set].m_ready[slot] = true;
-					}
-				}
-			}
-		}
+bool TextureSet::IsLoaded() const {
+	if(m_id == c_unused || g_textureSets[m_id].m_ready.empty()) { return false; }
+	return g_textureSets[m_id].m_readyCount == g_textureSets[m_id].m_ready.size();
+}
+
+void TextureSet::SetLoadedCallback(std::function<void(const std::string&)> a_callback) {
+	Core::Log::Assert(m_id != c_unused, "can't set a loaded callback on an empty texture set");
+	g_textureSets[m_id].m_loadedCallback = move(a_callback);
+}
+
+bool Graphics::TextureSets::HasCompletedTasks() {
+	DrainCompletionQueue();
+	return !g_completed.empty();
+}
+
+Core::Span<const uint16_t> Graphics::TextureSets::CheckLoadingTasks(CommandBuffer& a_cmdBuffer) {
+	g_readyTextures.clear();
+	DrainCompletionQueue();
+	for(const auto& loaded : g_completed) {
+		auto& textureSet = g_textureSets[loaded.Set];
+		if(!g_used[loaded.Set] || textureSet.m_generation != loaded.Generation) { continue; }
+
+		Commands::TransitionFromTransferQueue(a_cmdBuffer, textureSet.m_images[loaded.Slot],
+		                                      textureSet.m_headers[loaded.Slot].Frames);
+		textureSet.m_ready[loaded.Slot] = true;
+		++textureSet.m_readyCount;
+		g_readyTextures.push_back(CalcID(loaded.Set, loaded.Slot));
+		if(textureSet.m_loadedCallback) { textureSet.m_loadedCallback(textureSet.m_names[loaded.Slot]); }
 	}
+	g_completed.clear();
+
+	return {g_readyTextures.data(), g_readyTextures.size()};
 }
 
 TextureSet::TextureSet(const Core::Span<TextureCreateInfo> a_textures) {
@@ -156,10 +264,6 @@ TextureSet::TextureSet(const Core::Span<TextureCreateInfo> a_textures) {
 
 	g_used[set] = true;
 
-	vector<uint32_t> memOffsets;
-	memOffsets.reserve(a_textures.size());
-	uint32_t memOffset{0};
-
 	auto& device = GetDevice();
 
 	g_textureSets[set].m_names.reserve(a_textures.size());
@@ -167,7 +271,7 @@ TextureSet::TextureSet(const Core::Span<TextureCreateInfo> a_textures) {
 	g_textureSets[set].m_headers.reserve(a_textures.size());
 	g_textureSets[set].m_images.reserve(a_textures.size());
 	g_textureSets[set].m_views.reserve(a_textures.size());
-	g_textureSets[set].m_loadingTask.reserve(a_textures.size());
+	g_textureSets[set].m_imageMemory.reserve(a_textures.size());
 	g_textureSets[set].m_ready.reserve(a_textures.size());
 	vector<vector<byte>> textureDataList;
 	for(uint32_t slot = 0; slot < a_textures.size(); ++slot) {
@@ -181,9 +285,11 @@ TextureSet::TextureSet(const Core::Span<TextureCreateInfo> a_textures) {
 		}
 		Core::Log::Require(descSlot != c_maxTextures, "Ran out of available texture descriptor slots");
 
+		auto readStart = chrono::steady_clock::now();
 		vector<byte> textureData;
 		textureData.insert(begin(textureData), a_textures[slot].TextureData.data(),
 		                   a_textures[slot].TextureData.data() + a_textures[slot].TextureData.size());
+		AddLoadStage(g_readStage, textureData.size(), readStart);
 		Core::Log::Require(textureData.size() >= sizeof(Header), "corrupt crtex file {}", a_textures[slot].Name);
 
 		Core::Log::Require(textureData.size() <= c_maxStagingTextureSize, "texture is too large {}",
@@ -212,25 +318,16 @@ TextureSet::TextureSet(const Core::Span<TextureCreateInfo> a_textures) {
 		createInfo.flags         = vk::ImageCreateFlags{0};
 		createInfo.format        = vk::Format::eBc7SrgbBlock;
 
-		g_textureSets[set].m_images.push_back(device.createImage(createInfo));
-
-		auto imageRequirements = device.getImageMemoryRequirements(g_textureSets[set].m_images.back());
-		memOffset = (uint32_t)((memOffset + (imageRequirements.alignment - 1)) & ~(imageRequirements.alignment - 1));
-		memOffsets.push_back(memOffset);
-		memOffset += (uint32_t)imageRequirements.size;
+		g_textureSets[set].m_images.push_back(device.createImage(createInfo, HostAllocator::Get()));
+		g_textureSets[set].m_imageMemory.push_back(
+		    MemoryAllocator::Allocate(g_textureSets[set].m_images.back(), MemoryUsage::GpuOnly));
 
 		textureDataList.push_back(move(textureData));
 
 		g_textureSets[set].m_textureIndex.push_back(descSlot);
 	}
 
-	vk::MemoryAllocateInfo allocInfo;
-	allocInfo.memoryTypeIndex        = GetDeviceMemoryIndex();
-	allocInfo.allocationSize         = memOffset;
-	g_textureSets[set].m_imageMemory = device.allocateMemory(allocInfo);
-
 	for(uint32_t slot = 0; slot < a_textures.size(); ++slot) {
-		device.bindImageMemory(g_textureSets[set].m_images[slot], g_textureSets[set].m_imageMemory, memOffsets[slot]);
 		vk::ImageViewCreateInfo viewInfo;
 		viewInfo.image                           = g_textureSets[set].m_images[slot];
 		viewInfo.viewType                        = vk::ImageViewType::e2DArray;
@@ -241,13 +338,21 @@ TextureSet::TextureSet(const Core::Span<TextureCreateInfo> a_textures) {
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount     = g_textureSets[set].m_headers[slot].Frames;
 
-		g_textureSets[set].m_views.push_back(device.createImageView(viewInfo));
+		g_textureSets[set].m_views.push_back(device.createImageView(viewInfo, HostAllocator::Get()));
+
+		uint16_t descSlot       = g_textureSets[set].m_textureIndex[slot];
+		g_slotVersion[descSlot] = g_version + 1;
+		g_slotViews[descSlot]   = g_textureSets[set].m_views.back();
+		g_descriptorJournal.push_back({g_version + 1, descSlot});
 	}
+	TrimDescriptorJournal();
 
+	g_textureSets[set].m_pendingLoads.store((uint32_t)a_textures.size(), memory_order_release);
 	for(uint32_t slot = 0; slot < a_textures.size(); ++slot) {
 		g_textureSets[set].m_ready.push_back(false);
-		g_textureSets[set].m_loadingTask.push_back(AssetLoadingThread::LoadAsset(
-		    [textureData = move(textureDataList[slot]), set, slot](auto getCmdBuffer, auto submit) {
+		AssetLoadingThread::LoadAsset(
+		    [textureData = move(textureDataList[slot]), set, slot,
+		     generation = g_textureSets[set].m_generation](auto getCmdBuffer, auto submit) {
 			    Core::BinaryReader reader;
 			    reader.Data = textureData.data();
 			    reader.Size = (uint32_t)textureData.size();
@@ -266,31 +371,51 @@ TextureSet::TextureSet(const Core::Span<TextureCreateInfo> a_textures) {
 				    std::vector<std::byte> compressedData;
 				    Core::Read(reader, compressedData);
 
-				    Core::storage_buffer<byte> uncompressedData = DataCompression::Decompress(
-				        CR::Core::Span<const byte>(compressedData.data(), compressedData.size()));
-
-				    memcpy(g_stagingData, uncompressedData.data(), uncompressedData.size());
+				    auto stageStart = chrono::steady_clock::now();
+				    Core::storage_buffer<byte> uncompressedData = [&]() {
+					    CR_TRACE_SCOPE("Decompress");
+					    return DataCompression::Decompress(
+					        CR::Core::Span<const byte>(compressedData.data(), compressedData.size()));
+				    }();
+				    AddLoadStage(g_decodeStage, uncompressedData.size(), stageStart);
+				    stageStart = chrono::steady_clock::now();
+				    {
+					    CR_TRACE_SCOPE("StagingCopy");
+					    memcpy(g_stagingData, uncompressedData.data(), uncompressedData.size());
+				    }
+				    AddLoadStage(g_stagingStage, uncompressedData.size(), stageStart);
 
 				    Commands::CopyBufferToImg(cmdBuffer, g_stagingBuffer, g_textureSets[set].m_images[slot],
 				                              {header.Width, header.Height}, i);
+				    stageStart = chrono::steady_clock::now();
 				    submit();
+				    AddLoadStage(g_gpuCopyStage, uncompressedData.size(), stageStart);
 			    }
 			    {
 				    CommandBuffer& cmdBuffer = getCmdBuffer();
 				    Commands::TransitionToGraphicsQueue(cmdBuffer, g_textureSets[set].m_images[slot], header.Frames);
 				    submit();
 			    }
-		    }));
+
+			    g_texturesLoaded.fetch_add(1, memory_order_relaxed);
+			    LoadedTexture loaded{set, (uint16_t)slot, generation};
+			    while(!g_completionQueue.Push(loaded)) { this_thread::yield(); }
+			    g_textureSets[set].m_pendingLoads.fetch_sub(1, memory_order_acq_rel);
+		    });
 	}
 	textureDataList.clear();
 
 	++g_version;
 
 	m_id = set;
+	ApiRecorder::CreateTextureSet(m_id, a_textures);
 }
 
 void TextureSets::Init() {
 	g_used.reset();
+	g_descriptorJournal.clear();
+	g_journalStartVersion = 0;
+	Core::fill(g_slotVersion, 0);
 
 	vk::BufferCreateInfo stagInfo;
 	stagInfo.flags       = vk::BufferCreateFlags{};
@@ -298,24 +423,16 @@ void TextureSets::Init() {
 	stagInfo.size        = c_maxStagingTextureSize;
 	stagInfo.usage       = vk::BufferUsageFlagBits::eTransferSrc;
 
-	auto& device            = GetDevice();
-	g_stagingBuffer         = device.createBuffer(stagInfo);
-	auto bufferRequirements = device.getBufferMemoryRequirements(g_stagingBuffer);
-
-	vk::MemoryAllocateInfo allocInfo;
-	allocInfo.memoryTypeIndex = GetHostMemoryIndex();
-	allocInfo.allocationSize  = bufferRequirements.size;
-	g_stagingMemory           = device.allocateMemory(allocInfo);
-	device.bindBufferMemory(g_stagingBuffer, g_stagingMemory, 0);
-
-	g_stagingData = device.mapMemory(g_stagingMemory, 0, VK_WHOLE_SIZE);
+	auto& device    = GetDevice();
+	g_stagingBuffer = device.createBuffer(stagInfo, HostAllocator::Get());
+	g_stagingMemory = MemoryAllocator::Allocate(g_stagingBuffer, MemoryUsage::Upload);
+	g_stagingData   = g_stagingMemory.Data;
 }
 
 void TextureSets::Shutdown() {
 	auto& device = GetDevice();
-	device.unmapMemory(g_stagingMemory);
-	device.freeMemory(g_stagingMemory);
-	device.destroyBuffer(g_stagingBuffer);
+	device.destroyBuffer(g_stagingBuffer, HostAllocator::Get());
+	MemoryAllocator::Free(g_stagingMemory);
 }
 
 uint32_t TextureSets::GetCurrentVersion() {
@@ -332,6 +449,26 @@ void TextureSets::GetImageData(std::vector<vk::ImageView>& a_images, std::vector
 	}
 }
 
+void TextureSets::GetImageDataSince(uint32_t a_version, std::vector<vk::ImageView>& a_images,
+                                    std::vector<uint16_t>& a_imageIndices) {
+	if(a_version < g_journalStartVersion) {
+		GetImageData(a_images, a_imageIndices);
+		return;
+	}
+
+	for(auto iter = rbegin(g_descriptorJournal); iter != rend(g_descriptorJournal) && iter->Version > a_version;
+	    ++iter) {
+		// skip slots that have since been freed or given to a newer texture, the newer entry covers those.
+		if(g_slotVersion[iter->DescSlot] != iter->Version) { continue; }
+		a_images.push_back(g_slotViews[iter->DescSlot]);
+		a_imageIndices.push_back(iter->DescSlot);
+	}
+}
+
+bool TextureSets::HasTexture(const char* a_textureName) {
+	return g_lookup.find(a_textureName) != g_lookup.end();
+}
+
 uint16_t TextureSets::GetTextureIndex(const char* a_textureName) {
 	auto texIter = g_lookup.find(a_textureName);
 	Core::Log::Assert(texIter != g_lookup.end(), "Requested a texture {} that hasn't been loaded", a_textureName);
@@ -352,3 +489,21 @@ bool TextureSets::IsReady(uint16_t a_textureIndex) {
 
 	return g_textureSets[set].m_ready[slot];
 }
+
+TextureLoadStats Graphics::GetTextureLoadStats() {
+	TextureLoadStats result;
+	result.Read           = GetLoadStage(g_readStage);
+	result.Decode         = GetLoadStage(g_decodeStage);
+	result.Staging        = GetLoadStage(g_stagingStage);
+	result.GpuCopy        = GetLoadStage(g_gpuCopyStage);
+	result.TexturesLoaded = g_texturesLoaded.load(memory_order_relaxed);
+	return result;
+}
+
+void Graphics::ResetTextureLoadStats() {
+	for(LoadStage* stage : {&g_readStage, &g_decodeStage, &g_stagingStage, &g_gpuCopyStage}) {
+		stage->Bytes.store(0, memory_order_relaxed);
+		stage->Ns.store(0, memory_order_relaxed);
+	}
+	g_texturesLoaded.store(0, memory_order_relaxed);
+}
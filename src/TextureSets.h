@@ -3,6 +3,8 @@
 #include "CommandPool.h"
 #include "EngineInternal.h"
 
+#include "core/Span.h"
+
 #include <string_view>
 #include <vector>
 
@@ -12,9 +14,19 @@ namespace CR::Graphics::TextureSets {
 
 	uint32_t GetCurrentVersion();
 	void GetImageData(std::vector<vk::ImageView>& a_images, std::vector<uint16_t>& a_imageIndices);
+	// Only the descriptor slots that were given a new image after a_version. Falls back to GetImageData if the history
+	// doesn't go back that far.
+	void GetImageDataSince(uint32_t a_version, std::vector<vk::ImageView>& a_images,
+	                       std::vector<uint16_t>& a_imageIndices);
+	// False once the set it was in is freed.
+	bool HasTexture(const char* a_textureName);
 	uint16_t GetTextureIndex(const char* a_textureName);
 	uint16_t GetMaxFrames(uint16_t a_textureIndex);
 	bool IsReady(uint16_t a_textureIndex);
 
-	void CheckLoadingTasks(CommandBuffer& a_cmdBuffer);
+	// Processes textures the loading thread has finished since the last call. Returns the texture indices that became
+	// ready, only valid until the next call.
+	Core::Span<const uint16_t> CheckLoadingTasks(CommandBuffer& a_cmdBuffer);
+	// True if CheckLoadingTasks has work to do, without needing a command buffer.
+	bool HasCompletedTasks();
 }    // namespace CR::Graphics::TextureSets
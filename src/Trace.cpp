@@ -0,0 +1,88 @@
+﻿#include "Trace.h"
+
+#include "Graphics/Engine.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+// Nothing is traced in final builds, don't want the event ring taking up memory there either.
+#if !CR_FINAL
+namespace {
+	static_assert((Trace::c_maxEvents & (Trace::c_maxEvents - 1)) == 0, "c_maxEvents must be a power of 2");
+
+	struct Event {
+		const char* Name{nullptr};
+		uint64_t Begin{0};    // ns
+		uint64_t End{0};
+		uint32_t ThreadID{0};
+	};
+
+	Event g_events[Trace::c_maxEvents];
+	atomic_uint64_t g_nextEvent{0};
+	atomic_uint32_t g_nextThreadID{0};
+	const chrono::steady_clock::time_point g_start = chrono::steady_clock::now();
+
+	uint64_t Now() {
+		return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - g_start).count();
+	}
+
+	uint32_t GetThreadID() {
+		thread_local uint32_t id = g_nextThreadID.fetch_add(1, memory_order_relaxed);
+		return id;
+	}
+}    // namespace
+
+Trace::Scope::Scope(const char* a_name) : m_name(a_name), m_begin(Now()) {}
+
+Trace::Scope::~Scope() {
+	Event& event   = g_events[g_nextEvent.fetch_add(1, memory_order_relaxed) & (c_maxEvents - 1)];
+	event.Name     = m_name;
+	event.Begin    = m_begin;
+	event.End      = Now();
+	event.ThreadID = GetThreadID();
+}
+
+string Trace::ToChromeJson() {
+	uint64_t end   = g_nextEvent.load(memory_order_acquire);
+	uint64_t begin = end > c_maxEvents ? end - c_maxEvents : 0;
+
+	string result = "{\"traceEvents\":[\n";
+	bool first    = true;
+	for(uint64_t i = begin; i < end; ++i) {
+		const Event& event = g_events[i & (c_maxEvents - 1)];
+		if(event.Name == nullptr) { continue; }
+		if(!first) { result += ",\n"; }
+		first = false;
+		// complete events, times in microseconds
+		result += "{\"name\":\"";
+		result += event.Name;
+		result += "\",\"ph\":\"X\",\"pid\":0,\"tid\":";
+		result += to_string(event.ThreadID);
+		result += ",\"ts\":";
+		result += to_string(event.Begin / 1000.0);
+		result += ",\"dur\":";
+		result += to_string((event.End - event.Begin) / 1000.0);
+		result += "}";
+	}
+	result += "\n]}\n";
+	return result;
+}
+#endif
+
+bool Graphics::WriteTrace(const std::filesystem::path& a_path) {
+#if CR_FINAL
+	(void)a_path;
+	return false;
+#else
+	ofstream file(a_path, ios::binary);
+	if(!file) { return false; }
+	string json = Trace::ToChromeJson();
+	file.write(json.data(), json.size());
+	return (bool)file;
+#endif
+}
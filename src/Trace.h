@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped cpu trace markers, kept in a fixed size in memory ring of the most recent events. Can be dumped as chrome
+// trace json, open it in chrome://tracing or ui.perfetto.dev. Thread safe. Use CR_TRACE_SCOPE. None of this exists
+// in final builds, the macro compiles to nothing there.
+#if !CR_FINAL
+namespace CR::Graphics::Trace {
+	inline constexpr uint32_t c_maxEvents = 16384;
+
+	class Scope {
+	  public:
+		// a_name must outlive the trace, a string literal is intended.
+		explicit Scope(const char* a_name);
+		~Scope();
+		Scope(const Scope&) = delete;
+		Scope(Scope&&)      = delete;
+		Scope& operator=(const Scope&) = delete;
+		Scope& operator=(Scope&&) = delete;
+
+	  private:
+		const char* m_name;
+		uint64_t m_begin;
+	};
+
+	// Events still being written while this runs may come out garbled, fine for a diagnostic dump.
+	[[nodiscard]] std::string ToChromeJson();
+}    // namespace CR::Graphics::Trace
+#endif
+
+#define CR_TRACE_CONCAT_IMPL(a, b) a##b
+#define CR_TRACE_CONCAT(a, b) CR_TRACE_CONCAT_IMPL(a, b)
+#if CR_FINAL
+#define CR_TRACE_SCOPE(name)
+#else
+#define CR_TRACE_SCOPE(name) CR::Graphics::Trace::Scope CR_TRACE_CONCAT(crTraceScope, __LINE__)(name)
+#endif
@@ -1,12 +1,16 @@
 ﻿#include "UniformBufferDynamic.h"
 
+#include "HostAllocator.h"
+#include "MemoryAllocator.h"
+
 #include "core/Log.h"
 
 using namespace std;
 using namespace CR;
 using namespace CR::Graphics;
 
-// Note that this is implemented in an ideal way for mobile hardware, it is slow for desktop hardware
+// Lives in device local memory when the gpu exposes it to the cpu(ReBAR, UMA), otherwise the gpu reads it over the bus.
+// Use a UniformBufferRing on top of this for per draw data.
 UniformBufferDynamic::UniformBufferDynamic(uint32_t a_bytes) : m_size(a_bytes) {
 	Core::Log::Assert(a_bytes % 256 == 0, "uniform buffers must be a multiple of 256 bytes in size");
 
@@ -18,19 +22,13 @@ UniformBufferDynamic::UniformBufferDynamic(uint32_t a_bytes) : m_size(a_bytes) {
 
 	// main buffer
 	auto& device            = GetDevice();
-	m_Buffer                = device.createBuffer(createInfo);
+	m_Buffer                = device.createBuffer(createInfo, HostAllocator::Get());
 	auto bufferRequirements = device.getBufferMemoryRequirements(m_Buffer);
-
-	vk::MemoryAllocateInfo allocInfo;
-	allocInfo.memoryTypeIndex = GetHostMemoryIndex();
 	Core::Log::Assert(bufferRequirements.alignment <= 256,
 	                  "Currently assuming a 256 alignment will always be sufficient for uniform buffers");
-	allocInfo.allocationSize = bufferRequirements.size;
-	m_BufferMemory           = device.allocateMemory(allocInfo);
-
-	device.bindBufferMemory(m_Buffer, m_BufferMemory, 0);
 
-	m_data = (std::byte*)device.mapMemory(m_BufferMemory, 0, VK_WHOLE_SIZE);
+	m_BufferMemory = MemoryAllocator::Allocate(m_Buffer, MemoryUsage::Stream);
+	m_data         = m_BufferMemory.Data;
 }
 
 UniformBufferDynamic::~UniformBufferDynamic() {
@@ -49,7 +47,7 @@ UniformBufferDynamic& UniformBufferDynamic::operator=(UniformBufferDynamic&& a_o
 	m_size         = a_other.m_size;
 
 	a_other.m_Buffer       = vk::Buffer{};
-	a_other.m_BufferMemory = vk::DeviceMemory{};
+	a_other.m_BufferMemory = Allocation{};
 	a_other.m_data         = nullptr;
 	a_other.m_size         = 0;
 
@@ -58,9 +56,13 @@ UniformBufferDynamic& UniformBufferDynamic::operator=(UniformBufferDynamic&& a_o
 
 void UniformBufferDynamic::Free() {
 	if(m_Buffer) {
-		auto& device = GetDevice();
-		device.unmapMemory(m_BufferMemory);
-		device.destroyBuffer(m_Buffer);
-		device.freeMemory(m_BufferMemory);
+		// frames still in flight can be reading from it.
+		ExecuteNextFrame([buffer = m_Buffer, bufferMemory = m_BufferMemory]() mutable {
+			GetDevice().destroyBuffer(buffer, HostAllocator::Get());
+			MemoryAllocator::Free(bufferMemory);
+		});
+		m_Buffer       = vk::Buffer{};
+		m_BufferMemory = Allocation{};
+		m_data         = nullptr;
 	}
 }
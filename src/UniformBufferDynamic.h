@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "EngineInternal.h"
+#include "MemoryAllocator.h"
 #include "vulkan/vulkan.hpp"
 
 #include <memory>
@@ -29,7 +30,7 @@ namespace CR::Graphics {
 		void Free();
 
 		vk::Buffer m_Buffer;
-		vk::DeviceMemory m_BufferMemory;
+		Allocation m_BufferMemory;
 		std::byte* m_data{nullptr};
 		uint32_t m_size;
 	};
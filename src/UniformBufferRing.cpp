@@ -0,0 +1,55 @@
+﻿#include "UniformBufferRing.h"
+
+#include "EngineInternal.h"
+
+#include "core/Log.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace CR;
+using namespace CR::Graphics;
+
+namespace {
+	// max minUniformBufferOffsetAlignment allowed by the spec.
+	constexpr uint32_t c_alignment{256};
+}    // namespace
+
+UniformBufferRing::UniformBufferRing(uint32_t a_bytes) : m_buffer(a_bytes) {
+	m_currentFrame = GetFrameNumber();
+}
+
+UniformBufferRing::Chunk UniformBufferRing::Allocate(uint32_t a_bytes) {
+	uint64_t frame = GetFrameNumber();
+	if(frame != m_currentFrame) {
+		m_frames.push_back({m_currentFrame, m_allocated});
+		m_currentFrame = frame;
+	}
+	Reclaim();
+
+	uint32_t capacity = m_buffer.GetSize();
+	uint32_t size     = (a_bytes + c_alignment - 1) & ~(c_alignment - 1);
+	Core::Log::Assert(size <= capacity, "Allocation of {} bytes can never fit in a ring of {} bytes", a_bytes,
+	                  capacity);
+
+	// chunks must be contiguous, skip whatever is left at the end of the buffer if it doesn't fit.
+	bool wrap        = m_head + size > capacity;
+	uint32_t padding = wrap ? capacity - m_head : 0;
+	Core::Log::Require(m_allocated - m_released + padding + size <= capacity,
+	                   "UniformBufferRing of {} bytes is full, the gpu is still using all of it", capacity);
+	if(wrap) { m_head = 0; }
+
+	Chunk result{m_buffer.GetData() + m_head, m_head};
+	m_head += size;
+	m_allocated += padding + size;
+	return result;
+}
+
+void UniformBufferRing::Reclaim() {
+	uint64_t completed = GetFramesCompleted();
+	auto inUse         = [&](const FrameMarker& a_marker) { return a_marker.Frame >= completed; };
+	auto firstInUse    = find_if(begin(m_frames), end(m_frames), inUse);
+	if(firstInUse == begin(m_frames)) { return; }
+	m_released = prev(firstInUse)->End;
+	m_frames.erase(begin(m_frames), firstInUse);
+}
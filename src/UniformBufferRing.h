@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "UniformBufferDynamic.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace CR::Graphics {
+	// Hands out 256 byte aligned chunks of one UniformBufferDynamic, i.e. per draw shader parameters. Space is
+	// recycled once the gpu has finished the frame the chunk was allocated in, so a chunk is only valid for the
+	// frame it was allocated in. Bind with the chunks Offset as the dynamic offset. Not thread safe.
+	class UniformBufferRing {
+	  public:
+		struct Chunk {
+			std::byte* Data{nullptr};
+			uint32_t Offset{0};
+		};
+
+		UniformBufferRing() = default;
+		UniformBufferRing(uint32_t a_bytes);
+		~UniformBufferRing()                   = default;
+		UniformBufferRing(UniformBufferRing&)  = delete;
+		UniformBufferRing(UniformBufferRing&&) = default;
+		UniformBufferRing& operator=(UniformBufferRing&) = delete;
+		UniformBufferRing& operator=(UniformBufferRing&&) = default;
+
+		[[nodiscard]] Chunk Allocate(uint32_t a_bytes);
+
+		template<typename T>
+		[[nodiscard]] T* Allocate(uint32_t& a_offset) {
+			Chunk chunk = Allocate((uint32_t)sizeof(T));
+			a_offset    = chunk.Offset;
+			return (T*)chunk.Data;
+		}
+
+		const vk::Buffer& GetHandle() const { return m_buffer.GetHandle(); }
+		uint32_t GetSize() { return m_buffer.GetSize(); }
+
+	  private:
+		void Reclaim();
+
+		struct FrameMarker {
+			uint64_t Frame{0};
+			uint64_t End{0};    // m_allocated when the frame was done allocating
+		};
+
+		UniformBufferDynamic m_buffer;
+		uint32_t m_head{0};
+		// Running totals, including padding skipped when wrapping. Difference is what is still in use by the gpu.
+		uint64_t m_allocated{0};
+		uint64_t m_released{0};
+		uint64_t m_currentFrame{0};
+		std::vector<FrameMarker> m_frames;
+	};
+}    // namespace CR::Graphics
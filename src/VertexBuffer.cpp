@@ -1,6 +1,9 @@
 ﻿#include "VertexBuffer.h"
 
 #include "Commands.h"
+#include "Constants.h"
+#include "HostAllocator.h"
+#include "MemoryAllocator.h"
 
 #include "core/Log.h"
 
@@ -8,42 +11,42 @@ using namespace std;
 using namespace CR;
 using namespace CR::Graphics;
 
-detail::VertexBufferBase::VertexBufferBase(const VertexBufferLayout& a_layout, uint32_t a_vertCount, void** a_data) {
+namespace {
+	constexpr vk::MemoryPropertyFlags c_directWriteFlags{vk::MemoryPropertyFlagBits::eDeviceLocal |
+	                                                     vk::MemoryPropertyFlagBits::eHostVisible};
+}
+
+detail::VertexBufferBase::VertexBufferBase(const VertexBufferLayout& a_layout, uint32_t a_vertCount) {
+	m_frameSize = a_layout.GetStride() * a_vertCount;
+
 	vk::BufferCreateInfo createInfo;
 	createInfo.flags       = vk::BufferCreateFlags{};
 	createInfo.sharingMode = vk::SharingMode::eExclusive;
-	createInfo.size        = a_layout.GetStride() * a_vertCount;
-	createInfo.usage       = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst;
-
-	// main buffer
-	auto& device            = GetDevice();
-	m_buffer                = device.createBuffer(createInfo);
-	auto bufferRequirements = device.getBufferMemoryRequirements(m_buffer);
-
-	vk::MemoryAllocateInfo allocInfo;
-	allocInfo.memoryTypeIndex = GetDeviceMemoryIndex();
-	Core::Log::Assert(bufferRequirements.alignment <= 256,
-	                  "Currently assuming a 256 alignment will always be sufficient for uniform buffers");
-	allocInfo.allocationSize = bufferRequirements.size;
-	m_bufferMemory           = device.allocateMemory(allocInfo);
-
-	device.bindBufferMemory(m_buffer, m_bufferMemory, 0);
-
-	// staging buffer
-	createInfo.usage   = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc;
-	m_stagingBuffer    = device.createBuffer(createInfo);
-	bufferRequirements = device.getBufferMemoryRequirements(m_stagingBuffer);
-
-	vk::MemoryAllocateInfo stagAllocInfo;
-	stagAllocInfo.memoryTypeIndex = GetHostMemoryIndex();
-	Core::Log::Assert(bufferRequirements.alignment <= 256,
-	                  "Currently assuming a 256 alignment will always be sufficient for uniform buffers");
-	stagAllocInfo.allocationSize = bufferRequirements.size;
-	m_stagingBufferMemory        = device.allocateMemory(stagAllocInfo);
-
-	device.bindBufferMemory(m_stagingBuffer, m_stagingBufferMemory, 0);
-
-	*a_data = device.mapMemory(m_stagingBufferMemory, 0, VK_WHOLE_SIZE);
+	createInfo.size        = m_frameSize * c_maxFramesInFlight;
+	createInfo.usage       = vk::BufferUsageFlagBits::eVertexBuffer;
+
+	auto& device = GetDevice();
+
+	// Try for memory we can write directly first, fall back to staging if that isn't what we got.
+	m_buffer       = device.createBuffer(createInfo, HostAllocator::Get());
+	m_bufferMemory = MemoryAllocator::Allocate(m_buffer, MemoryUsage::Stream);
+	m_directWrite  = (MemoryAllocator::GetMemoryFlags(m_bufferMemory.MemoryType) & c_directWriteFlags) ==
+	                c_directWriteFlags;
+
+	if(!m_directWrite) {
+		device.destroyBuffer(m_buffer, HostAllocator::Get());
+		MemoryAllocator::Free(m_bufferMemory);
+
+		// main buffer, still one copy per frame in flight so we never copy over data an earlier frame is reading.
+		createInfo.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst;
+		m_buffer         = device.createBuffer(createInfo, HostAllocator::Get());
+		m_bufferMemory   = MemoryAllocator::Allocate(m_buffer, MemoryUsage::GpuOnly);
+
+		// staging buffer
+		createInfo.usage      = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc;
+		m_stagingBuffer       = device.createBuffer(createInfo, HostAllocator::Get());
+		m_stagingBufferMemory = MemoryAllocator::Allocate(m_stagingBuffer, MemoryUsage::Upload);
+	}
 
 	// Only support instance vertex buffers at the moment. And binding would need to be changed in the pipeline as
 	// appropriate, although only ever 1 binding at the moment.
@@ -72,6 +75,8 @@ detail::VertexBufferBase::VertexBufferBase(VertexBufferBase&& a_other) noexcept
 detail::VertexBufferBase& detail::VertexBufferBase::operator=(VertexBufferBase&& a_other) noexcept {
 	Free();
 
+	m_directWrite         = a_other.m_directWrite;
+	m_frameSize           = a_other.m_frameSize;
 	m_buffer              = a_other.m_buffer;
 	m_bufferMemory        = a_other.m_bufferMemory;
 	m_stagingBuffer       = a_other.m_stagingBuffer;
@@ -80,29 +85,49 @@ detail::VertexBufferBase& detail::VertexBufferBase::operator=(VertexBufferBase&&
 	m_attrDescriptions    = std::move(a_other.m_attrDescriptions);
 
 	a_other.m_buffer              = vk::Buffer{};
-	a_other.m_bufferMemory        = vk::DeviceMemory{};
+	a_other.m_bufferMemory        = Allocation{};
 	a_other.m_stagingBuffer       = vk::Buffer{};
-	a_other.m_stagingBufferMemory = vk::DeviceMemory{};
+	a_other.m_stagingBufferMemory = Allocation{};
 
 	return *this;
 }
 
 void detail::VertexBufferBase::Free() {
 	if(m_buffer) {
-		auto& device = GetDevice();
-		device.unmapMemory(m_stagingBufferMemory);
-		device.destroyBuffer(m_stagingBuffer);
-		device.freeMemory(m_stagingBufferMemory);
-		device.destroyBuffer(m_buffer);
-		device.freeMemory(m_bufferMemory);
+		// frames still in flight can be reading from these.
+		ExecuteNextFrame([buffer = m_buffer, bufferMemory = m_bufferMemory, stagingBuffer = m_stagingBuffer,
+		                  stagingBufferMemory = m_stagingBufferMemory]() mutable {
+			auto& device = GetDevice();
+			device.destroyBuffer(stagingBuffer, HostAllocator::Get());
+			MemoryAllocator::Free(stagingBufferMemory);
+			device.destroyBuffer(buffer, HostAllocator::Get());
+			MemoryAllocator::Free(bufferMemory);
+		});
+		m_buffer              = vk::Buffer{};
+		m_bufferMemory        = Allocation{};
+		m_stagingBuffer       = vk::Buffer{};
+		m_stagingBufferMemory = Allocation{};
 	}
 }
 
+vk::DeviceSize detail::VertexBufferBase::GetOffset() const noexcept {
+	return (vk::DeviceSize)GetFrameIndex() * m_frameSize;
+}
+
+void* detail::VertexBufferBase::GetData() const noexcept {
+	if(m_directWrite) { return m_bufferMemory.Data + GetOffset(); }
+	return m_stagingBufferMemory.Data + GetOffset();
+}
+
+// Host writes to coherent memory are visible to anything submitted after them, nothing to do for direct writes.
 void detail::VertexBufferBase::Release(CommandBuffer& a_cmdBuffer, uint32_t a_sizeBytes) {
-	Commands::CopyBufferToBuffer(a_cmdBuffer, m_stagingBuffer, m_buffer, a_sizeBytes);
-	Commands::SetEvent(a_cmdBuffer, m_copyEvent);
+	if(m_directWrite) { return; }
+	Commands::CopyBufferToBuffer(a_cmdBuffer, m_stagingBuffer, m_buffer, GetOffset(), a_sizeBytes);
+	Commands::SetEvent(a_cmdBuffer, m_copyEvents[GetFrameIndex()]);
 }
 
 void detail::VertexBufferBase::Acquire(CommandBuffer& a_cmdBuffer) {
-	Commands::WaitEvent(a_cmdBuffer, m_copyEvent);
+	if(m_directWrite) { return; }
+	Commands::WaitEvent(a_cmdBuffer, m_copyEvents[GetFrameIndex()]);
+	Commands::ResetEvent(a_cmdBuffer, m_copyEvents[GetFrameIndex()]);
 }
@@ -1,9 +1,11 @@
 ﻿#pragma once
 
 #include "CommandPool.h"
+#include "Constants.h"
 #include "EngineInternal.h"
 #include "Event.h"
 #include "Formats.h"
+#include "MemoryAllocator.h"
 
 #include <memory>
 #include <vector>
@@ -49,7 +51,7 @@ namespace CR::Graphics {
 		class VertexBufferBase {
 		  public:
 			VertexBufferBase() = default;
-			VertexBufferBase(const VertexBufferLayout& a_layout, uint32_t a_vertCount, void** a_data);
+			VertexBufferBase(const VertexBufferLayout& a_layout, uint32_t a_vertCount);
 			~VertexBufferBase();
 			VertexBufferBase(VertexBufferBase&) = delete;
 			VertexBufferBase(VertexBufferBase&& a_other) noexcept;
@@ -67,16 +69,27 @@ namespace CR::Graphics {
 			void Acquire(CommandBuffer& a_cmdBuffer);
 
 			[[nodiscard]] const vk::Buffer& GetHandle() const noexcept { return m_buffer; }
+			// Where this frames data starts in the buffer returned by GetHandle.
+			[[nodiscard]] vk::DeviceSize GetOffset() const noexcept;
+			// Where the cpu should write this frames data.
+			[[nodiscard]] void* GetData() const noexcept;
 
 		  private:
 			void Free();
 
+			// If the gpu can read host visible device local memory(ReBAR, or UMA), write straight into the vertex
+			// buffer. Otherwise write to a staging buffer and copy. Either way one copy per frame in flight.
+			bool m_directWrite{false};
+			uint32_t m_frameSize{0};
+
 			vk::Buffer m_buffer;
-			vk::DeviceMemory m_bufferMemory;
+			Allocation m_bufferMemory;
 			vk::Buffer m_stagingBuffer;
-			vk::DeviceMemory m_stagingBufferMemory;
+			Allocation m_stagingBufferMemory;
 
-			Event m_copyEvent;
+			// One per frame in flight, reset once waited on. A single event would stay set, and a later frame's wait
+			// wouldn't wait for its own copy.
+			Event m_copyEvents[c_maxFramesInFlight];
 
 			vk::VertexInputBindingDescription m_bindingDescription;
 			std::vector<vk::VertexInputAttributeDescription> m_attrDescriptions;
@@ -88,10 +101,7 @@ namespace CR::Graphics {
 	  public:
 		VertexBuffer() = default;
 		VertexBuffer(const VertexBufferLayout& a_layout, uint32_t a_vertCount) :
-		    m_base(a_layout, a_vertCount, (void**)&m_data) {
-			m_size   = a_vertCount;
-			m_stride = a_layout.GetStride();
-		}
+		    m_size(a_vertCount), m_stride(a_layout.GetStride()), m_base(a_layout, a_vertCount) {}
 		~VertexBuffer()                = default;
 		VertexBuffer(VertexBuffer<T>&) = delete;
 		VertexBuffer(VertexBuffer<T>&& a_other) noexcept;
@@ -99,13 +109,15 @@ namespace CR::Graphics {
 		VertexBuffer& operator                    =(VertexBuffer<T>&& a_other) noexcept;
 
 		[[nodiscard]] const vk::Buffer& GetHandle() const noexcept { return m_base.GetHandle(); }
+		[[nodiscard]] vk::DeviceSize GetOffset() const noexcept { return m_base.GetOffset(); }
 
-		[[nodiscard]] T* begin() noexcept { return m_data; }
-		[[nodiscard]] const T* begin() const noexcept { return m_data; }
-		[[nodiscard]] const T* cbegin() const noexcept { return m_data; }
-		[[nodiscard]] T* end() noexcept { return m_data + m_size; }
-		[[nodiscard]] const T* end() const noexcept { return m_data + m_size; }
-		[[nodiscard]] const T* cend() const noexcept { return m_data + m_size; }
+		// Iterators are only valid for the current frame, the memory behind them can change every frame.
+		[[nodiscard]] T* begin() noexcept { return (T*)m_base.GetData(); }
+		[[nodiscard]] const T* begin() const noexcept { return (const T*)m_base.GetData(); }
+		[[nodiscard]] const T* cbegin() const noexcept { return (const T*)m_base.GetData(); }
+		[[nodiscard]] T* end() noexcept { return begin() + m_size; }
+		[[nodiscard]] const T* end() const noexcept { return begin() + m_size; }
+		[[nodiscard]] const T* cend() const noexcept { return cbegin() + m_size; }
 
 		[[nodiscard]] bool empty() const noexcept { return m_size == 0; }
 
@@ -124,11 +136,9 @@ namespace CR::Graphics {
 		void Acquire(CommandBuffer& a_cmdBuffer) { m_base.Acquire(a_cmdBuffer); }
 
 	  private:
-		T* m_data{nullptr};
 		uint32_t m_size{0};
 		uint32_t m_stride{0};
 
-		// must be last, so it initializes last
 		detail::VertexBufferBase m_base;
 	};
 
@@ -150,11 +160,9 @@ namespace CR::Graphics {
 	template<typename T>
 	VertexBuffer<T>& VertexBuffer<T>::operator=(VertexBuffer<T>&& a_other) noexcept {
 		m_base   = std::move(a_other.m_base);
-		m_data   = a_other.m_data;
 		m_size   = a_other.m_size;
 		m_stride = a_other.m_stride;
 
-		a_other.m_data = nullptr;
 		a_other.m_size = 0;
 
 		return *this;
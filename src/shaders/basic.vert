@@ -14,8 +14,9 @@ layout(location = 2) out flat mediump uint TextureIndex;
 
 const vec2 Vertices[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0));
 
-layout (constant_id = 0) const float InvScreenSizeX = 1.0/1280.0;
-layout (constant_id = 1) const float InvScreenSizeY = 1.0/720.0;
+layout(push_constant) uniform PushConstants {
+  vec2 InvScreenSize;
+} Constants;
 
 void main() {
   vec2 position = Vertices[gl_VertexIndex];
@@ -30,7 +31,7 @@ void main() {
   position += Offset;
 
   // from pixel coords to -1to1
-  vec2 pos = (position * vec2(2.0) * vec2(InvScreenSizeX, InvScreenSizeY)) - vec2(1.0);
+  vec2 pos = (position * vec2(2.0) * Constants.InvScreenSize) - vec2(1.0);
   gl_Position = vec4(pos.x, pos.y, 0.0, 1.0);
 
   Color = ColorIn;
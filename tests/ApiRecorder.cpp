@@ -0,0 +1,156 @@
+﻿#include <3rdParty/doctest.h>
+
+#include "ApiRecorder.h"
+#include "Graphics/Engine.h"
+#include "Graphics/SpriteBasic.h"
+#include "Graphics/TextureSet.h"
+#include "Platform/MemoryMappedFile.h"
+#include "Platform/PathUtils.h"
+#include "TestFixture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace CR;
+using namespace CR::Graphics;
+using namespace std;
+using ApiCall = ApiRecorder::ApiCall;
+
+TEST_CASE("api recorder") {
+	auto path = Platform::GetCurrentProcessPath() / "api_recorder_test.crrec";
+	Platform::MemoryMappedFile crtexLeaf(Platform::GetCurrentProcessPath() / "leaf.crtexd");
+
+	// the engine is already running, so start recording by hand instead of through EngineSettings::RecordPath
+	EngineSettings settings;
+	settings.ApplicationName = "recorder test";
+	settings.MsaaSamples     = 2;
+	settings.ClearColor      = glm::vec4(0.0f, 0.5f, 1.0f, 1.0f);
+	ApiRecorder::Start(path, settings);
+
+	uint16_t spriteIndex = 0;
+	{
+		TextureCreateInfo texInfo;
+		texInfo.TextureData = Core::Span<const byte>{crtexLeaf.data(), crtexLeaf.size()};
+		texInfo.Name        = "leaf";
+		TextureSet texSet({&texInfo, 1});
+		// same crtex data, should only be stored once
+		texInfo.Name = "leaf_again";
+		TextureSet texSetAgain({&texInfo, 1});
+
+		SpriteTemplateBasicCreateInfo templateInfo;
+		templateInfo.Name        = "leaf template";
+		templateInfo.TextureName = "leaf";
+		templateInfo.FrameSize   = {88, 88};
+		templateInfo.FrameRate   = eFrameRate::FPS20;
+		templateInfo.BlendMode   = eBlendMode::Alpha;
+		auto spriteTemplate      = CreateSpriteTemplateBasic(templateInfo);
+
+		SpriteBasicCreateInfo spriteInfo;
+		spriteInfo.Name     = "recorded sprite";
+		spriteInfo.Template = spriteTemplate;
+		SpriteBasic sprite(spriteInfo);
+		spriteIndex = sprite.GetIndex();
+		sprite.SetPosition({1.0f, 2.0f});
+		sprite.SetColor({0.25f, 0.5f, 0.75f, 1.0f});
+		sprite.SetRotation(0.5f);
+
+		Frame();
+		Frame();
+	}
+	ApiRecorder::Stop();
+
+	Platform::MemoryMappedFile file(path);
+	ApiRecorder::Reader reader({file.data(), file.size()});
+
+	REQUIRE(reader.ReadCall() == ApiCall::CreateEngine);
+	EngineSettings recordedSettings = reader.ReadSettings();
+	CHECK(recordedSettings.ApplicationName == "recorder test");
+	CHECK(recordedSettings.MsaaSamples == 2);
+	REQUIRE(recordedSettings.ClearColor.has_value());
+	CHECK(recordedSettings.ClearColor->y == 0.5f);
+
+	REQUIRE(reader.ReadCall() == ApiCall::TextureData);
+	uint32_t dataID                 = reader.Read<uint32_t>();
+	Core::Span<const byte> dataRead = reader.ReadBytes();
+	REQUIRE(dataRead.size() == crtexLeaf.size());
+	CHECK(memcmp(dataRead.data(), crtexLeaf.data(), crtexLeaf.size()) == 0);
+
+	REQUIRE(reader.ReadCall() == ApiCall::CreateTextureSet);
+	uint16_t set = reader.Read<uint16_t>();
+	REQUIRE(reader.Read<uint16_t>() == 1);
+	CHECK(reader.ReadString() == "leaf");
+	CHECK(reader.Read<uint32_t>() == dataID);
+
+	// no TextureData this time
+	REQUIRE(reader.ReadCall() == ApiCall::CreateTextureSet);
+	uint16_t setAgain = reader.Read<uint16_t>();
+	CHECK(setAgain != set);
+	REQUIRE(reader.Read<uint16_t>() == 1);
+	CHECK(reader.ReadString() == "leaf_again");
+	CHECK(reader.Read<uint32_t>() == dataID);
+
+	REQUIRE(reader.ReadCall() == ApiCall::CreateSpriteTemplate);
+	uint8_t templateIndex = reader.Read<uint8_t>();
+	CHECK(reader.ReadString() == "leaf template");
+	CHECK(reader.ReadString() == "leaf");
+	CHECK(reader.Read<glm::uvec2>() == glm::uvec2(88, 88));
+	CHECK(reader.Read<uint8_t>() == (uint8_t)eFrameRate::FPS20);
+	CHECK(reader.Read<uint8_t>() == (uint8_t)eBlendMode::Alpha);
+	CHECK(reader.Read<bool>() == true);
+
+	REQUIRE(reader.ReadCall() == ApiCall::CreateSprite);
+	CHECK(reader.Read<uint16_t>() == spriteIndex);
+	CHECK(reader.ReadString() == "recorded sprite");
+	CHECK(reader.Read<uint8_t>() == templateIndex);
+
+	REQUIRE(reader.ReadCall() == ApiCall::SetSpritePosition);
+	CHECK(reader.Read<uint16_t>() == spriteIndex);
+	CHECK(reader.Read<glm::vec2>() == glm::vec2(1.0f, 2.0f));
+	REQUIRE(reader.ReadCall() == ApiCall::SetSpriteColor);
+	CHECK(reader.Read<uint16_t>() == spriteIndex);
+	CHECK(reader.Read<glm::vec4>() == glm::vec4(0.25f, 0.5f, 0.75f, 1.0f));
+	REQUIRE(reader.ReadCall() == ApiCall::SetSpriteRotation);
+	CHECK(reader.Read<uint16_t>() == spriteIndex);
+	CHECK(reader.Read<float>() == 0.5f);
+
+	REQUIRE(reader.ReadCall() == ApiCall::Frame);
+	uint64_t firstFrameTime = reader.Read<uint64_t>();
+	REQUIRE(reader.ReadCall() == ApiCall::Frame);
+	CHECK(reader.Read<uint64_t>() >= firstFrameTime);
+
+	// everything created above is destroyed before recording stops. The template may outlive the sprite manager's
+	// reference, so its destruction isn't required.
+	vector<uint16_t> destroyedSets;
+	bool spriteDestroyed = false;
+	bool shutdown        = false;
+	while(!reader.AtEnd() && !shutdown) {
+		switch(reader.ReadCall()) {
+			case ApiCall::DestroySprite:
+				spriteDestroyed = reader.Read<uint16_t>() == spriteIndex;
+				break;
+			case ApiCall::DestroySpriteTemplate:
+				CHECK(reader.Read<uint8_t>() == templateIndex);
+				break;
+			case ApiCall::DestroyTextureSet:
+				destroyedSets.push_back(reader.Read<uint16_t>());
+				break;
+			case ApiCall::ShutdownEngine:
+				shutdown = true;
+				break;
+			default:
+				FAIL("unexpected api call recorded");
+		}
+	}
+	CHECK(shutdown);
+	CHECK(reader.AtEnd());
+	CHECK(spriteDestroyed);
+	CHECK(destroyedSets.size() == 2);
+	CHECK(find(begin(destroyedSets), end(destroyedSets), set) != end(destroyedSets));
+	CHECK(find(begin(destroyedSets), end(destroyedSets), setAgain) != end(destroyedSets));
+
+	// cut off inside the application name, as a crash part way through writing would leave it.
+	ApiRecorder::Reader truncated({file.data(), sizeof(ApiRecorder::Header) + sizeof(ApiCall) + sizeof(uint16_t) + 2});
+	REQUIRE(truncated.ReadCall() == ApiCall::CreateEngine);
+	CHECK_THROWS_AS((void)truncated.ReadSettings(), ApiRecorder::TruncatedError);
+}
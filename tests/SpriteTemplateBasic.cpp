@@ -1,13 +1,19 @@
 ﻿#include <3rdParty/doctest.h>
 
 #include "Graphics/Engine.h"
+#include "Graphics/SpriteBasic.h"
 #include "Graphics/SpriteTemplateBasic.h"
 #include "Graphics/TextureSet.h"
+#include "NullDevice.h"
 #include "Platform/MemoryMappedFile.h"
 #include "Platform/PathUtils.h"
 
 #include "TestFixture.h"
 
+#include <algorithm>
+#include <cstring>
+#include <map>
+
 using namespace CR;
 using namespace CR::Graphics;
 using namespace std;
@@ -25,3 +31,46 @@ TEST_CASE("sprite_template_basic") {
 	templateInfo.TextureName = "completion_screen";
 	auto spriteTemplate      = CreateSpriteTemplateBasic(templateInfo);
 }
+
+TEST_CASE("sprite_template_variants") {
+	Platform::MemoryMappedFile crtexLeaf(Platform::GetCurrentProcessPath() / "leaf.crtexd");
+	TextureCreateInfo texInfo;
+	texInfo.TextureData = Core::Span<const byte>{crtexLeaf.data(), crtexLeaf.size()};
+	texInfo.Name        = "leaf";
+	TextureSet texSet({&texInfo, 1});
+
+	SpriteTemplateBasicCreateInfo templateInfo;
+	templateInfo.Name        = "opaque template";
+	templateInfo.FrameSize   = {88, 88};
+	templateInfo.FrameRate   = eFrameRate::None;
+	templateInfo.TextureName = "leaf";
+	auto opaqueTemplate      = CreateSpriteTemplateBasic(templateInfo);
+
+	templateInfo.Name          = "blended template";
+	templateInfo.BlendMode     = eBlendMode::Alpha;
+	templateInfo.SampleShading = false;
+	auto blendedTemplate       = CreateSpriteTemplateBasic(templateInfo);
+
+	SpriteBasicCreateInfo spriteInfo;
+	spriteInfo.Name     = "opaque sprite";
+	spriteInfo.Template = opaqueTemplate;
+	SpriteBasic opaqueSprite(spriteInfo);
+	spriteInfo.Name     = "blended sprite";
+	spriteInfo.Template = blendedTemplate;
+	SpriteBasic blendedSprite(spriteInfo);
+
+	// only counts once both variants have compiled, each template's sprites wait on their own variant.
+	uint32_t mostDrawsInABuffer = 0;
+	(void)NullDevice::TakeCommandLog();
+	for(int loops = 0; loops < 1000 && GetFrameStats().SpritesDrawn != 2; ++loops) {
+		Frame();
+		std::map<VkCommandBuffer, uint32_t> draws;
+		for(const auto& command : NullDevice::TakeCommandLog()) {
+			if(strcmp(command.Name, "vkCmdDraw") == 0) { ++draws[(VkCommandBuffer)command.CommandBuffer]; }
+		}
+		for(const auto& [buffer, count] : draws) { mostDrawsInABuffer = std::max(mostDrawsInABuffer, count); }
+	}
+	REQUIRE(GetFrameStats().SpritesDrawn == 2);
+	// different variants can't share a draw
+	if(UseNullBackend()) { CHECK(mostDrawsInABuffer == 2); }
+}
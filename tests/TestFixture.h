@@ -1,9 +1,17 @@
 ﻿#pragma once
 
 #include "Graphics/Engine.h"
+#include "Platform/PathUtils.h"
 
 #include <3rdParty/glfw.h>
 
+#include <cstdlib>
+
+// Set CR_GRAPHICS_NULL_BACKEND to run the tests on a machine without a gpu.
+inline bool UseNullBackend() {
+	return std::getenv("CR_GRAPHICS_NULL_BACKEND") != nullptr;
+}
+
 class TestFixture {
   protected:
 	GLFWwindow* Window{nullptr};
@@ -11,16 +19,24 @@ class TestFixture {
 
   public:
 	TestFixture() {
-		glfwInit();
+		// The null backend needs no window, so the tests can run on a machine without a display either.
+		int refreshRate = 60;
+		CR::Graphics::EngineSettings settings;
+		if(!UseNullBackend()) {
+			glfwInit();
 
-		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-		Window = glfwCreateWindow(1280, 720, "Vulkan window", nullptr, nullptr);
+			glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+			glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+			Window = glfwCreateWindow(1280, 720, "Vulkan window", nullptr, nullptr);
 
-		GLFWmonitor* primaryMonitor    = glfwGetPrimaryMonitor();
-		const GLFWvidmode* displayMode = glfwGetVideoMode(primaryMonitor);
+			GLFWmonitor* primaryMonitor    = glfwGetPrimaryMonitor();
+			const GLFWvidmode* displayMode = glfwGetVideoMode(primaryMonitor);
+			refreshRate                    = displayMode->refreshRate;
 
-		CR::Graphics::EngineSettings settings;
+			settings.ExtensionsToEnable = glfwGetRequiredInstanceExtensions(&settings.ExtensionsToEnableCount);
+			settings.Hwnd               = glfwGetWin32Window(Window);
+			settings.HInstance          = GetModuleHandle(nullptr);
+		}
 		settings.ApplicationName    = "Unit Test";
 		settings.ApplicationVersion = 1;
 		if constexpr(CR_DEBUG || CR_RELEASE) {
@@ -28,12 +44,11 @@ class TestFixture {
 		} else {
 			settings.EnableDebug = false;
 		}
-		settings.ExtensionsToEnable = glfwGetRequiredInstanceExtensions(&settings.ExtensionsToEnableCount);
-		settings.Hwnd               = glfwGetWin32Window(Window);
-		settings.HInstance          = GetModuleHandle(nullptr);
-		settings.ClearColor         = glm::vec4(0.0f, 0.0f, 0.75f, 1.0f);
-		settings.RefreshRate        = displayMode->refreshRate;
-		m_frameTime                 = 1.0f / displayMode->refreshRate;
+		settings.ClearColor        = glm::vec4(0.0f, 0.0f, 0.75f, 1.0f);
+		settings.RefreshRate       = refreshRate;
+		settings.PipelineCachePath = CR::Platform::GetCurrentProcessPath() / "pipeline.cache";
+		settings.NullBackend       = UseNullBackend();
+		m_frameTime                = 1.0f / refreshRate;
 
 		CR::Graphics::CreateEngine(settings);
 	}
@@ -41,8 +56,7 @@ class TestFixture {
 	~TestFixture() {
 		CR::Graphics::ShutdownEngine();
 
-		glfwDestroyWindow(Window);
-
+		if(Window != nullptr) { glfwDestroyWindow(Window); }
 		glfwTerminate();
 	}
 };
@@ -5,6 +5,8 @@
 #include "Platform/MemoryMappedFile.h"
 #include "Platform/PathUtils.h"
 #include "TestFixture.h"
+#include "TextureSets.h"
+#include <algorithm>
 #include <vector>
 
 using namespace CR;
@@ -21,3 +23,78 @@ TEST_CASE("texture_set") {
 	texInfo[1].Name        = "completion_screen";
 	TextureSet texSet({texInfo, 2});
 }
+
+TEST_CASE("texture_set_loaded_callback") {
+	Platform::MemoryMappedFile crtexLeaf(Platform::GetCurrentProcessPath() / "leaf.crtexd");
+	Platform::MemoryMappedFile crtexBrick(Platform::GetCurrentProcessPath() / "brick.crtexd");
+
+	TextureCreateInfo texInfo[2];
+	texInfo[0].TextureData = Core::Span<const byte>{crtexLeaf.data(), crtexLeaf.size()};
+	texInfo[0].Name        = "leaf";
+	texInfo[1].TextureData = Core::Span<const byte>{crtexBrick.data(), crtexBrick.size()};
+	texInfo[1].Name        = "brick";
+
+	TextureSet texSet({texInfo, 2});
+	vector<string> loaded;
+	texSet.SetLoadedCallback([&](const string& a_name) { loaded.push_back(a_name); });
+
+	for(int loops = 0; loops < 1000 && !texSet.IsLoaded(); ++loops) { Frame(); }
+	REQUIRE(texSet.IsLoaded());
+	// callbacks only come from Frame, so none were missed by setting it after creating the set.
+	REQUIRE(loaded.size() == 2);
+	CHECK(find(begin(loaded), end(loaded), "leaf") != end(loaded));
+	CHECK(find(begin(loaded), end(loaded), "brick") != end(loaded));
+}
+
+TEST_CASE("texture_load_stats") {
+	Platform::MemoryMappedFile crtexLeaf(Platform::GetCurrentProcessPath() / "leaf.crtexd");
+
+	TextureCreateInfo texInfo;
+	texInfo.TextureData = Core::Span<const byte>{crtexLeaf.data(), crtexLeaf.size()};
+	texInfo.Name        = "leaf";
+
+	ResetTextureLoadStats();
+	TextureSet texSet({&texInfo, 1});
+	for(int loops = 0; loops < 1000 && !texSet.IsLoaded(); ++loops) { Frame(); }
+	REQUIRE(texSet.IsLoaded());
+
+	TextureLoadStats stats = GetTextureLoadStats();
+	CHECK(stats.TexturesLoaded == 1);
+	CHECK(stats.Read.Bytes == crtexLeaf.size());
+	CHECK(stats.Decode.Bytes > 0);
+	CHECK(stats.Staging.Bytes == stats.Decode.Bytes);
+	CHECK(stats.GpuCopy.Bytes == stats.Decode.Bytes);
+}
+
+TEST_CASE("texture_set_move_assign_frees") {
+	Platform::MemoryMappedFile crtexLeaf(Platform::GetCurrentProcessPath() / "leaf.crtexd");
+	Platform::MemoryMappedFile crtexBrick(Platform::GetCurrentProcessPath() / "brick.crtexd");
+
+	// held the whole time, so the sets assigned below aren't the first one. Freeing one of them must leave it alone.
+	TextureCreateInfo brickInfo;
+	brickInfo.TextureData = Core::Span<const byte>{crtexBrick.data(), crtexBrick.size()};
+	brickInfo.Name        = "move_assign_brick";
+	TextureSet brickSet({&brickInfo, 1});
+
+	// far more sets than can exist at once, only works if assigning over a set frees it.
+	TextureSet texSet;
+	CHECK_FALSE(texSet.IsLoaded());
+	for(int i = 0; i < 16; ++i) {
+		TextureCreateInfo texInfo;
+		texInfo.TextureData = Core::Span<const byte>{crtexLeaf.data(), crtexLeaf.size()};
+		texInfo.Name        = fmt::format("leaf_{}", i);
+		texSet              = TextureSet({&texInfo, 1});
+		CHECK(TextureSets::HasTexture(texInfo.Name.c_str()));
+		if(i > 0) { CHECK_FALSE(TextureSets::HasTexture(fmt::format("leaf_{}", i - 1).c_str())); }
+	}
+	CHECK(TextureSets::HasTexture("move_assign_brick"));
+
+	for(int loops = 0; loops < 1000 && !(texSet.IsLoaded() && brickSet.IsLoaded()); ++loops) { Frame(); }
+	CHECK(texSet.IsLoaded());
+	CHECK(brickSet.IsLoaded());
+
+	texSet = TextureSet{};
+	CHECK_FALSE(texSet.IsLoaded());
+	CHECK_FALSE(TextureSets::HasTexture("leaf_15"));
+	CHECK(TextureSets::HasTexture("move_assign_brick"));
+}
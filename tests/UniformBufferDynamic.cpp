@@ -4,6 +4,7 @@
 
 #include "Graphics/Engine.h"
 #include "UniformBufferDynamic.h"
+#include "UniformBufferRing.h"
 #include "core/literals.h"
 
 using namespace CR::Graphics;
@@ -15,3 +16,24 @@ TEST_CASE("uniform buffer") {
 	REQUIRE(data != nullptr);
 	for(uint32_t i = 0; i < 1_Kb; ++i) { data[i] = 1.0f; }
 }
+
+TEST_CASE("uniform buffer ring") {
+	UniformBufferRing ring((uint32_t)4_Kb);
+	auto first  = ring.Allocate(16);
+	auto second = ring.Allocate(300);
+	REQUIRE(first.Data != nullptr);
+	CHECK(second.Offset == first.Offset + 256);
+	CHECK(second.Data == first.Data + 256);
+
+	// Many times the size of the ring, only fits if space from finished frames is reused.
+	for(int frame = 0; frame < 16; ++frame) {
+		for(int i = 0; i < 6; ++i) {
+			uint32_t offset = 0;
+			float* value    = ring.Allocate<float>(offset);
+			REQUIRE(value != nullptr);
+			CHECK(offset % 256 == 0);
+			*value = 1.0f;
+		}
+		Frame();
+	}
+}